@@ -4,44 +4,127 @@
 #include <vector>
 #include <sstream>
 #include <string>
+#include <optional>
+#include <utility>
+
+#include "../../util/Intcode.h"
+#include "../../util/Parallel.h"
 
 using namespace std;
+using namespace aoc::util::intcode;
+using namespace aoc::util::parallel;
+
+#define TARGET_OUTPUT 19690720
+#define MAX_NOUN_VERB 100
+
+void printMemory(const IntcodeVM &vm, const size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        cout << vm.read(i) << " ";
+    }
 
-typedef vector<int> memory_t;
+    cout << endl;
+}
 
-// overload the stream input operator to read comma separated integers from each line of an input file
-// into a vector of integers
-istream &operator>>(istream &ins, memory_t &data)
+// runs a fork of the loaded program with the given noun and verb, returning the value left at address 0
+optional<cell_t> runWithNounVerb(const IntcodeVM &loadedVM, const cell_t noun, const cell_t verb)
 {
-    // clear the output first
-    data.clear();
+    IntcodeVM vm = loadedVM.fork();
 
-    // separate the integers from the commas
-    string sVal;
-    while (getline(ins, sVal, ','))
+    // set noun and verb parameters
+    vm.write(1, noun);
+    vm.write(2, verb);
+
+    if (vm.run() != kHalted)
+    {
+        return nullopt;
+    }
+
+    return vm.read(0);
+}
+
+// The day 2 programs only ever add and multiply the noun and verb by constants, so the output is
+// usually linear in both of them: output = base + noun * nounStep + verb * verbStep. We sample the
+// program to get the coefficients, check the linearity on a few more points, and then only have to
+// solve for the verb once per noun (verifying the candidate by actually running it).
+optional<pair<cell_t, cell_t>> findNounVerbLinear(const IntcodeVM &loadedVM, const cell_t target)
+{
+    const auto base = runWithNounVerb(loadedVM, 0, 0);
+    const auto nounOne = runWithNounVerb(loadedVM, 1, 0);
+    const auto verbOne = runWithNounVerb(loadedVM, 0, 1);
+    if (!base || !nounOne || !verbOne)
     {
-        // we convert each string value from the comma separated values into an integer
-        stringstream intAsString(sVal);
-        int val = 0;
-        intAsString >> val;
+        return nullopt;
+    }
+
+    const cell_t nounStep = *nounOne - *base;
+    const cell_t verbStep = *verbOne - *base;
+
+    for (const auto &[noun, verb] : vector<pair<cell_t, cell_t>>{{MAX_NOUN_VERB - 1, MAX_NOUN_VERB - 1}, {37, 58}, {64, 3}})
+    {
+        const auto output = runWithNounVerb(loadedVM, noun, verb);
+        if (!output || *output != *base + noun * nounStep + verb * verbStep)
+        {
+            return nullopt;
+        }
+    }
+
+    for (cell_t noun = 0; noun < MAX_NOUN_VERB; noun++)
+    {
+        const cell_t remainder = target - *base - noun * nounStep;
+
+        cell_t verb = 0;
+        if (verbStep == 0)
+        {
+            if (remainder != 0)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            if (remainder % verbStep != 0 || remainder / verbStep < 0 || remainder / verbStep >= MAX_NOUN_VERB)
+            {
+                continue;
+            }
+            verb = remainder / verbStep;
+        }
 
-        // now push it into the vector
-        data.push_back(val);
+        if (runWithNounVerb(loadedVM, noun, verb) == target)
+        {
+            return pair(noun, verb);
+        }
     }
 
-    // we converted values from the csv line from the file as a vector of ints
-    // we can return the argument stream, as per the overload
-    return ins;
+    return nullopt;
 }
 
-void printMemory(const memory_t &memory)
+// brute force over all noun/verb pairs, one noun per task; the smallest matching noun wins
+optional<pair<cell_t, cell_t>> findNounVerbSearch(const IntcodeVM &loadedVM, const cell_t target)
 {
-    for (int i = 0; i < memory.size(); i++)
+    vector<cell_t> verbForNoun(MAX_NOUN_VERB, -1);
+    parallelFor(MAX_NOUN_VERB, [&](const size_t noun)
     {
-        cout << memory[i] << " ";
+        for (cell_t verb = 0; verb < MAX_NOUN_VERB; verb++)
+        {
+            if (runWithNounVerb(loadedVM, noun, verb) == target)
+            {
+                verbForNoun[noun] = verb;
+                break;
+            }
+        }
+    });
+
+    for (cell_t noun = 0; noun < MAX_NOUN_VERB; noun++)
+    {
+        if (verbForNoun[noun] != -1)
+        {
+            return pair(noun, verbForNoun[noun]);
+        }
     }
 
-    cout << endl;
+    return nullopt;
 }
 
 void part1(istream &inputFile)
@@ -51,42 +134,18 @@ void part1(istream &inputFile)
         // read one line from the file
         string line;
         getline(inputFile, line);
-        stringstream ss(line);
 
-        // separate the integers from the commas
-        memory_t memory;
-        ss >> memory;
+        const IntcodeVM loadedVM(parseProgram(line));
 
         // set memory to "1202 program alarm"
-        memory[1] = 12;
-        memory[2] = 2;
-
-        // now parse the program instructions
-        int i = 0;
-        while (memory[i] != 99)
+        const auto output = runWithNounVerb(loadedVM, 12, 2);
+        if (!output)
         {
-            int a = memory[memory[i + 1]];
-            int b = memory[memory[i + 2]];
-
-            switch (memory[i])
-            {
-            case 1:
-                memory[memory[i + 3]] = a + b;
-                break;
-            case 2:
-                memory[memory[i + 3]] = a * b;
-                break;
-            default:
-                cout << "Unknown OPCODE: " << memory[i] << endl;
-                break;
-            }
-
-            // advance to next opcode
-            i += 4;
+            cout << "Program did not halt cleanly" << endl;
+            continue;
         }
 
-        // printMemory(memory);
-        cout << memory[0] << endl;
+        cout << *output << endl;
     }
 }
 
@@ -97,60 +156,22 @@ void part2(istream &inputFile)
         // read one line from the file
         string line;
         getline(inputFile, line);
-        stringstream ss(line);
 
-        // separate the integers from the commas
-        memory_t memory;
-        ss >> memory;
+        const IntcodeVM loadedVM(parseProgram(line));
 
-        int noun = 0;
-        int verb = 0;
+        auto nounVerb = findNounVerbLinear(loadedVM, TARGET_OUTPUT);
+        if (!nounVerb)
+        {
+            nounVerb = findNounVerbSearch(loadedVM, TARGET_OUTPUT);
+        }
 
-        bool done = false;
-        for (int i = 0; i < 100 && !done; i++)
+        if (!nounVerb)
         {
-            noun = i;
-            for (int j = 0; j < 100 && !done; j++)
-            {
-                verb = j;
-
-                memory_t memoryCopy(memory);
-
-                // set noun and verb parameters
-                memoryCopy[1] = noun;
-                memoryCopy[2] = verb;
-
-                // now parse the program instructions
-                int i = 0;
-                while (memoryCopy[i] != 99)
-                {
-                    int a = memoryCopy[memoryCopy[i + 1]];
-                    int b = memoryCopy[memoryCopy[i + 2]];
-
-                    switch (memoryCopy[i])
-                    {
-                    case 1:
-                        memoryCopy[memoryCopy[i + 3]] = a + b;
-                        break;
-                    case 2:
-                        memoryCopy[memoryCopy[i + 3]] = a * b;
-                        break;
-                    default:
-                        break;
-                    }
-
-                    i += 4;
-                }
-
-                if (memoryCopy[0] == 19690720)
-                {
-                    done = true;
-                }
-            }
+            cout << "No noun and verb produce " << TARGET_OUTPUT << endl;
+            continue;
         }
 
-        // printMemory(memory);
-        cout << 100 * noun + verb << endl;
+        cout << 100 * nounVerb->first + nounVerb->second << endl;
     }
 }
 
@@ -177,4 +198,4 @@ int main(int argc, char **argv)
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -3,133 +3,204 @@
 #include <string>
 #include <sstream>
 #include <vector>
-#include <regex>
 #include <utility>
+#include <cstdint>
 
 using namespace std;
 
+enum OpCode : uint8_t
+{
+    Nop,
+    Acc,
+    Jmp,
+};
+
 struct Instruction
 {
-    Instruction(string o, int32_t a)
+    OpCode op;
+    int32_t arg;
+};
+
+struct RunResult
+{
+    int32_t accum;
+    bool hasLoop;
+};
+
+// Bitmap of the executed instructions, kept around so that consecutive runs don't reallocate it.
+class VisitedBitmap
+{
+public:
+    VisitedBitmap(const size_t size) : _words((size + 63) / 64, 0) {}
+
+    void clear()
     {
-        op = o;
-        arg = a;
+        fill(_words.begin(), _words.end(), 0);
     }
 
-    string op;
-    int32_t arg;
+    bool testAndSet(const size_t pos)
+    {
+        const uint64_t mask = 1ull << (pos % 64);
+        const bool wasSet = _words[pos / 64] & mask;
+        _words[pos / 64] |= mask;
+        return wasSet;
+    }
+
+private:
+    vector<uint64_t> _words;
 };
 
 void processInput(
     istream& inputFile,
-    vector<pair<Instruction, bool>>& instructions)
+    vector<Instruction>& instructions)
 {
-    const regex rx("(nop|acc|jmp) (.*)");
-
     // read input line by line
     while (!inputFile.eof())
     {
         string line;
         getline(inputFile, line);
 
-        smatch match;
-        if (regex_match(line, match, rx))
+        const string op = line.substr(0, 3);
+        if (line.size() < 5 || line[3] != ' ' || (op != "nop" && op != "acc" && op != "jmp"))
         {
-            string op = match[1].str();
-            int32_t arg;
-            istringstream ss(match[2].str());
-            ss >> arg;
-
-            instructions.emplace_back(Instruction(op, arg), false);
-        }
-        else
-        {
-            cout << "Line did not match instruction regex: " << line << endl;
+            cout << "Line did not match instruction format: " << line << endl;
             exit(1);
         }
+
+        const int32_t arg = stoi(line.substr(4));
+        const OpCode opCode = op == "nop" ? Nop : (op == "acc" ? Acc : Jmp);
+
+        instructions.push_back({opCode, arg});
     }
 }
 
-bool runProgram(vector<pair<Instruction, bool>>& instructions, int32_t& accumRet)
+// position of the instruction that runs after the one at pos, if the instruction was op
+inline int64_t nextPosition(const int64_t pos, const OpCode op, const int32_t arg)
 {
-    int32_t accum = 0;
-    size_t pos = 0;
+    return op == Jmp ? pos + arg : pos + 1;
+}
 
-    vector<pair<Instruction, bool>> instr = instructions;
+inline bool isTerminal(const int64_t pos, const vector<Instruction>& instructions)
+{
+    return pos < 0 || pos >= static_cast<int64_t>(instructions.size());
+}
 
-    while (pos < instr.size() && !instr[pos].second)
-    {
-        // get instruction
-        auto& instruction = instr[pos].first;
+// runs the program, optionally with the instruction at flipPos swapped between nop and jmp
+RunResult runProgram(const vector<Instruction>& instructions, VisitedBitmap& visited, const int64_t flipPos = -1)
+{
+    visited.clear();
 
-        // set instruction as executed
-        instr[pos].second = true;
+    int32_t accum = 0;
+    int64_t pos = 0;
 
-        // execute it based on which operation it represents
-        if (instruction.op == "nop")
-        {
-            pos += 1;
-        }
-        else if (instruction.op == "jmp")
-        {
-            pos += instruction.arg;
-        }
-        else if (instruction.op == "acc")
-        {
-            accum += instruction.arg;
-            pos += 1;
-        }
-        else
+    while (!isTerminal(pos, instructions) && !visited.testAndSet(pos))
+    {
+        auto [op, arg] = instructions[pos];
+        if (pos == flipPos)
         {
-            cout << "Unknown operator: ( " << instruction.op << ", " << instruction.arg << " )" << endl;
-            exit(1);
+            op = op == Nop ? Jmp : (op == Jmp ? Nop : op);
         }
-    }
 
-    bool hasLoop = false;
-    if (pos < instr.size())
-    {
-        hasLoop = instr[pos].second;
+        accum += op == Acc ? arg : 0;
+        pos = nextPosition(pos, op, arg);
     }
 
-    accumRet = accum;
-    return hasLoop;
+    return {accum, !isTerminal(pos, instructions)};
 }
 
-void part1(vector<pair<Instruction, bool>>& instructions)
+void part1(const vector<Instruction>& instructions)
 {
-    int32_t accum = 0;
-
-    runProgram(instructions, accum);
+    VisitedBitmap visited(instructions.size());
 
-    cout << accum << endl;
+    cout << runProgram(instructions, visited).accum << endl;
 }
 
-void part2(vector<pair<Instruction, bool>>& instructions)
+// Rather than re-running the program once per possible flip, find all the instructions that reach
+// the end of the program when left untouched (walking the jump graph backwards from the end), then
+// follow the original (looping) path and flip the first instruction that jumps into that set.
+void part2(const vector<Instruction>& instructions)
 {
-    bool hasLoop = true;
-    int32_t accum = 0;
+    const size_t n = instructions.size();
 
-    for (size_t i = 0; i < instructions.size() && hasLoop; ++i)
+    VisitedBitmap visited(n);
+    const auto originalResult = runProgram(instructions, visited);
+    if (!originalResult.hasLoop)
     {
-        accum = 0;
-        if (instructions[i].first.op == "nop")
-        {
-            vector<pair<Instruction, bool>> modifiedInstructions = instructions;
-            modifiedInstructions[i].first.op = "jmp";
+        // nothing to repair
+        cout << originalResult.accum << endl;
+        return;
+    }
 
-            hasLoop = runProgram(modifiedInstructions, accum);
-        }
-        else if (instructions[i].first.op == "jmp")
+    // predecessors of every position in CSR form, with position n standing in for "terminated"
+    vector<uint32_t> predecessorStarts(n + 2, 0);
+    vector<uint32_t> predecessors(n);
+    const auto getTarget = [&](const size_t pos)
+    {
+        const auto next = nextPosition(pos, instructions[pos].op, instructions[pos].arg);
+        return isTerminal(next, instructions) ? n : static_cast<size_t>(next);
+    };
+    for (size_t pos = 0; pos < n; ++pos)
+    {
+        predecessorStarts[getTarget(pos) + 1] += 1;
+    }
+    for (size_t pos = 0; pos <= n; ++pos)
+    {
+        predecessorStarts[pos + 1] += predecessorStarts[pos];
+    }
+    vector<uint32_t> fillPositions(predecessorStarts.begin(), predecessorStarts.end() - 1);
+    for (size_t pos = 0; pos < n; ++pos)
+    {
+        predecessors[fillPositions[getTarget(pos)]++] = pos;
+    }
+
+    vector<bool> reachesEnd(n + 1, false);
+    vector<uint32_t> toVisit = {static_cast<uint32_t>(n)};
+    reachesEnd[n] = true;
+    while (!toVisit.empty())
+    {
+        const auto pos = toVisit.back();
+        toVisit.pop_back();
+
+        for (size_t i = predecessorStarts[pos]; i < predecessorStarts[pos + 1]; ++i)
         {
-            vector<pair<Instruction, bool>> modifiedInstructions = instructions;
-            modifiedInstructions[i].first.op = "nop";
+            if (!reachesEnd[predecessors[i]])
+            {
+                reachesEnd[predecessors[i]] = true;
+                toVisit.push_back(predecessors[i]);
+            }
+        }
+    }
 
-            hasLoop = runProgram(modifiedInstructions, accum);
+    // walk the original (looping) path; none of its instructions reach the end, so the flipped one
+    // can't show up again on the way from its new target to the end
+    visited.clear();
+    int64_t flipPos = -1;
+    int64_t pos = 0;
+    while (!isTerminal(pos, instructions) && !visited.testAndSet(pos))
+    {
+        const auto [op, arg] = instructions[pos];
+        if (op != Acc)
+        {
+            const auto flippedNext = nextPosition(pos, op == Nop ? Jmp : Nop, arg);
+            if (isTerminal(flippedNext, instructions) || reachesEnd[flippedNext])
+            {
+                flipPos = pos;
+                break;
+            }
         }
+
+        pos = nextPosition(pos, op, arg);
+    }
+
+    if (flipPos == -1)
+    {
+        cout << "No single nop/jmp flip makes the program terminate" << endl;
+        return;
     }
 
-    cout << accum << endl;
+    const auto result = runProgram(instructions, visited, flipPos);
+
+    cout << result.accum << endl;
 }
 
 
@@ -144,7 +215,7 @@ int main(int argc, char **argv)
     cout << "Input file name: " << argv[1] << endl;
     ifstream inputFile(argv[1]);
 
-    vector<pair<Instruction, bool>> instructions;
+    vector<Instruction> instructions;
 
     processInput(inputFile, instructions);
 
@@ -160,4 +231,4 @@ int main(int argc, char **argv)
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -2,18 +2,54 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
-#include <stack>
+#include <array>
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <numeric>
 #include <utility>
 #include <cstdint>
 
+#include "../../util/Parallel.h"
+#include "../../util/StringUtil.h"
+
 using namespace std;
+using namespace aoc::util::parallel;
+using namespace aoc::util::string;
+
+#define MAX_STACK_DEPTH 256
+
+// binding power of each binary operator; higher binds tighter, all operators are left associative
+struct Precedence
+{
+    uint8_t plus;
+    uint8_t times;
+};
+
+const Precedence kSamePrecedence = {.plus = 1, .times = 1};
+const Precedence kAdditionFirst = {.plus = 2, .times = 1};
 
-uint64_t apply(const char op, const uint64_t a, const uint64_t b)
+enum OpCode : uint8_t
+{
+    Push,
+    Add,
+    Mul,
+};
+
+// Postfix bytecode of one expression; every Push takes the next value from constants.
+struct Bytecode
+{
+    vector<uint8_t> code;
+    vector<uint64_t> constants;
+    size_t maxStackDepth = 0;
+};
+
+uint64_t apply(const uint8_t op, const uint64_t a, const uint64_t b)
 {
     switch (op)
     {
-        case '+': return a + b; break;
-        case '*': return a * b; break;
+        case Add: return a + b; break;
+        case Mul: return a * b; break;
         default:
             cout << "Unknown operator: " << op << endl;
     }
@@ -21,252 +57,216 @@ uint64_t apply(const char op, const uint64_t a, const uint64_t b)
     return 0;
 }
 
-void part1(istream& inputFile)
+// Pratt parser emitting postfix bytecode for a single line. It runs on the worker threads, so a
+// malformed line is not reported here: compile() stops at the first error and returns false, and
+// error() describes it.
+class ExpressionCompiler
 {
-    uint64_t result = 0;
-    while (!inputFile.eof())
+public:
+    ExpressionCompiler(const string_view line, const Precedence &precedence, Bytecode &bytecode)
+        : _line(line), _precedence(precedence), _bytecode(bytecode) {}
+
+    bool compile()
     {
-        string line;
-        getline(inputFile, line);
+        _bytecode.code.clear();
+        _bytecode.constants.clear();
+        _bytecode.maxStackDepth = 0;
+        _stackDepth = 0;
 
-        stack<uint64_t> intermediaryResults;
-        stack<char> intermediaryOperators;
+        _parseExpression(0);
 
-        size_t i = 0;
-        while (i < line.size())
+        if (_error.empty() && _peek() != '\0')
         {
-            auto ch = line[i];
+            _fail("Unexpected character '" + string(1, _peek()) + "'");
+        }
 
-            if (ch == ' ')
-            {
-                i += 1;
+        return _error.empty();
+    }
 
-                continue;
-            }
+    const string& error() const
+    {
+        return _error;
+    }
 
-            if (ch == '+' || ch == '*' || ch == '(')
-            {
-                i += 1;
+private:
+    void _fail(const string &message)
+    {
+        if (_error.empty())
+        {
+            _error = message + " in line: " + string(_line);
+        }
+    }
 
-                intermediaryOperators.emplace(ch);
-            }
-            else if (ch == ')')
+    char _peek()
+    {
+        while (_pos < _line.size() && _line[_pos] == ' ')
+        {
+            _pos += 1;
+        }
+
+        return _pos < _line.size() ? _line[_pos] : '\0';
+    }
+
+    uint8_t _bindingPower(const char op) const
+    {
+        switch (op)
+        {
+            case '+': return _precedence.plus;
+            case '*': return _precedence.times;
+            default: return 0;
+        }
+    }
+
+    void _parsePrimary()
+    {
+        const auto ch = _peek();
+        if (ch == '(')
+        {
+            _pos += 1;
+            _parseExpression(0);
+            if (!_error.empty())
             {
-                i += 1;
-
-                if (intermediaryOperators.top() != '(')
-                {
-                    cout << "( was not found when closing )" << endl;
-                    exit(1);
-                }
-                else
-                {
-                    // pop the open parenthesis
-                    intermediaryOperators.pop();
-
-                    if (!intermediaryOperators.empty() && intermediaryOperators.top() != '(')
-                    {
-                        const auto res1 = intermediaryResults.top();
-                        intermediaryResults.pop();
-                        const auto res2 = intermediaryResults.top();
-                        intermediaryResults.pop();
-                        const auto op = intermediaryOperators.top();
-                        intermediaryOperators.pop();
-
-                        const auto res = apply(op, res2, res1);
-
-                        // cout << res2 << " " << op << " " << res1 << " = " << res << endl;
-
-                        intermediaryResults.emplace(res);
-                    }
-                }
+                return;
             }
-            else
+
+            if (_peek() != ')')
             {
-                // construct the number
-                ostringstream ss;
-                while (i < line.size() && ch != '+' && ch != '*' && ch != '(' && ch != ')')
-                {
-                    ss << ch;
-                    i += 1;
-                    ch = line[i];
-                }
-
-                string element = ss.str();
-
-                // we are reading a number
-                uint64_t num;
-                istringstream numSs(element);
-                numSs >> num;
-
-                if (intermediaryOperators.empty() || intermediaryOperators.top() == '(')
-                {
-                    // we just previously read a paranthesis, so start a new intermediary result
-                    intermediaryResults.emplace(num);
-                }
-                else
-                {
-                    // we didn't just previously read a paranthesis, we can accumulate the result so far
-                    const auto res = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto op = intermediaryOperators.top();
-                    intermediaryOperators.pop();
-
-                    const auto newRes = apply(op, res, num);
-
-                    // cout << res << " " << op << " " << num << " = " << newRes << endl;
-
-                    intermediaryResults.emplace(newRes);
-                }
+                _fail(") was not found when closing (");
+                return;
             }
+            _pos += 1;
+            return;
         }
 
-        const auto res = intermediaryResults.top();
-        intermediaryResults.pop();
+        if (ch < '0' || ch > '9')
+        {
+            _fail("Expected a number or (");
+            return;
+        }
 
-        // cout << res << endl;
+        uint64_t num = 0;
+        while (_pos < _line.size() && _line[_pos] >= '0' && _line[_pos] <= '9')
+        {
+            num = num * 10 + (_line[_pos] - '0');
+            _pos += 1;
+        }
 
-        result += res;
-    }
+        _bytecode.code.push_back(Push);
+        _bytecode.constants.push_back(num);
 
-    cout << result << endl;
-}
+        _stackDepth += 1;
+        _bytecode.maxStackDepth = max(_bytecode.maxStackDepth, _stackDepth);
+        if (_stackDepth > MAX_STACK_DEPTH)
+        {
+            _fail("Expression needs more than " + to_string(MAX_STACK_DEPTH) + " stack slots");
+        }
+    }
 
-void part2(istream& inputFile)
-{
-    uint64_t result = 0;
-    while (!inputFile.eof())
+    void _parseExpression(const uint8_t minBindingPower)
     {
-        string line;
-        getline(inputFile, line);
-
-        stack<uint64_t> intermediaryResults;
-        stack<char> intermediaryOperators;
+        _parsePrimary();
 
-        size_t i = 0;
-        while (i < line.size())
+        while (_error.empty())
         {
-            auto ch = line[i];
-
-            if (ch == ' ')
+            const auto op = _peek();
+            const auto bindingPower = _bindingPower(op);
+            if (bindingPower == 0 || bindingPower <= minBindingPower)
             {
-                i += 1;
-
-                continue;
+                break;
             }
 
-            if (ch == '+' || ch == '*' || ch == '(')
+            _pos += 1;
+            _parseExpression(bindingPower);
+            if (!_error.empty())
             {
-                i += 1;
-
-                intermediaryOperators.emplace(ch);
+                break;
             }
-            else if (ch == ')')
-            {
-                i += 1;
 
-                while (intermediaryOperators.top() != '(')
-                {
-                    const auto res1 = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto res2 = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto op = intermediaryOperators.top();
-                    intermediaryOperators.pop();
+            _bytecode.code.push_back(op == '+' ? Add : Mul);
+            _stackDepth -= 1;
+        }
+    }
+
+    const string_view _line;
+    const Precedence &_precedence;
+    Bytecode &_bytecode;
+    size_t _pos = 0;
+    size_t _stackDepth = 0;
+    string _error;
+};
 
-                    const auto res = apply(op, res2, res1);
+uint64_t evaluate(const Bytecode &bytecode)
+{
+    array<uint64_t, MAX_STACK_DEPTH> stack;
+    size_t top = 0;
+    size_t nextConstant = 0;
 
-                    // cout << res2 << " " << op << " " << res1 << " = " << res << endl;
+    for (const auto op : bytecode.code)
+    {
+        if (op == Push)
+        {
+            stack[top++] = bytecode.constants[nextConstant++];
+            continue;
+        }
 
-                    intermediaryResults.emplace(res);
-                }
+        top -= 1;
+        stack[top - 1] = apply(op, stack[top - 1], stack[top]);
+    }
 
-                // pop the open parenthesis
-                intermediaryOperators.pop();
+    return stack[0];
+}
 
-                if (!intermediaryOperators.empty() && intermediaryOperators.top() == '+')
-                {
-                    const auto res1 = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto res2 = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto op = intermediaryOperators.top();
-                    intermediaryOperators.pop();
+// Reads the whole input in one go and evaluates its lines in parallel, one chunk of lines per worker.
+// A worker stops at the first malformed line of its chunk; once all of them are joined, the first
+// error of the input is reported.
+uint64_t sumExpressions(istream& inputFile, const Precedence &precedence)
+{
+    const string input((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
 
-                    const auto res = apply(op, res2, res1);
+    const vector<string_view> lines = splitLines(input);
 
-                    // cout << res2 << " " << op << " " << res1 << " = " << res << endl;
+    const size_t numWorkers = getNumWorkers(lines.size());
+    vector<uint64_t> partialSums(numWorkers, 0);
+    vector<string> errors(numWorkers);
+    parallelForChunks(lines.size(), [&](const size_t workerIdx, const size_t startIdx, const size_t endIdx)
+    {
+        // the bytecode buffers are reused for every line of the chunk
+        Bytecode bytecode;
 
-                    intermediaryResults.emplace(res);
-                }
-            }
-            else
+        for (size_t i = startIdx; i < endIdx; ++i)
+        {
+            ExpressionCompiler compiler(lines[i], precedence, bytecode);
+            if (!compiler.compile())
             {
-                // construct the number
-                ostringstream ss;
-                while (i < line.size() && ch != '+' && ch != '*' && ch != '(' && ch != ')')
-                {
-                    ss << ch;
-                    i += 1;
-                    ch = line[i];
-                }
-
-                string element = ss.str();
-
-                // we are reading a number
-                uint64_t num;
-                istringstream numSs(element);
-                numSs >> num;
-
-                if (intermediaryOperators.empty() ||
-                    intermediaryOperators.top() == '(' ||
-                    intermediaryOperators.top() == '*')
-                {
-                    // we just previously read a paranthesis, so start a new intermediary result
-                    intermediaryResults.emplace(num);
-                }
-                else if (intermediaryOperators.top() == '+')
-                {
-                    // we didn't just previously read a paranthesis, we can accumulate the result so far
-                    const auto res = intermediaryResults.top();
-                    intermediaryResults.pop();
-                    const auto op = intermediaryOperators.top();
-                    intermediaryOperators.pop();
-
-                    const auto newRes = apply(op, res, num);
-
-                    // cout << res << " " << op << " " << num << " = " << newRes << endl;
-
-                    intermediaryResults.emplace(newRes);
-                }
+                errors[workerIdx] = compiler.error();
+                return;
             }
+
+            partialSums[workerIdx] += evaluate(bytecode);
         }
+    });
 
-        while (!intermediaryOperators.empty())
+    // the chunks are in input order
+    for (const auto& error : errors)
+    {
+        if (!error.empty())
         {
-            const auto res1 = intermediaryResults.top();
-            intermediaryResults.pop();
-            const auto res2 = intermediaryResults.top();
-            intermediaryResults.pop();
-            const auto op = intermediaryOperators.top();
-            intermediaryOperators.pop();
-
-            const auto res = apply(op, res2, res1);
-
-            // cout << res2 << " " << op << " " << res1 << " = " << res << endl;
-
-            intermediaryResults.emplace(res);
+            cout << error << endl;
+            exit(1);
         }
+    }
 
-        const auto res = intermediaryResults.top();
-        intermediaryResults.pop();
-
-        // cout << res << endl;
+    return accumulate(partialSums.begin(), partialSums.end(), uint64_t(0));
+}
 
-        result += res;
-    }
+void part1(istream& inputFile)
+{
+    cout << sumExpressions(inputFile, kSamePrecedence) << endl;
+}
 
-    cout << result << endl;
+void part2(istream& inputFile)
+{
+    cout << sumExpressions(inputFile, kAdditionFirst) << endl;
 }
 
 
@@ -293,4 +293,4 @@ int main(int argc, char **argv)
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -5,14 +5,19 @@
 #include <regex>
 #include <map>
 #include <utility>
+#include <algorithm>
+#include <numeric>
+#include <bit>
+
+#include "../../util/Parallel.h"
 
 using namespace std;
+using namespace aoc::util::parallel;
 
 #define DEBUG 0
 
 const regex INPUT_LINE("([0-9]+): (.*)");
 const regex TERMINAL_RULE("\"([ab])\"");
-const regex LIST_OF_LISTS_OF_RULES("([0-9 ]+) \\| ([0-9 ]+)");
 
 void readInput(istream& inputFile, map<uint64_t, string>& rules, vector<string>& messages)
 {
@@ -57,154 +62,243 @@ void readInput(istream& inputFile, map<uint64_t, string>& rules, vector<string>&
     }
 }
 
-const string cleanRuleList(const string ruleListStr)
+// Rules compiled once into integer-indexed form. A rule is either a terminal character or a
+// list of alternatives, each alternative being a sequence of rule ids. Missing rule ids compile
+// to rules with no alternatives, which never match.
+struct Grammar
 {
-    string ruleStr;
-    vector<string> ruleList;
+    vector<char> terminals;                         // rule id -> terminal char, or 0 if not terminal
+    vector<vector<vector<uint32_t>>> alternatives;  // rule id -> alternatives -> sequence of rule ids
+    vector<uint32_t> evaluationOrder;               // rule ids, ordered so that leftmost symbols come first
+    bool hasLeftCycle = false;
+};
 
-    istringstream ss(ruleListStr);
-    while (getline(ss, ruleStr, ' '))
-    {
-        ruleList.push_back(ruleStr);
-    }
-
-    ostringstream rulesList1;
-    for (size_t i = 0; i < ruleList.size(); ++i)
+void _orderByLeftmostSymbol(const uint32_t ruleId, Grammar& grammar, vector<uint8_t>& state)
+{
+    // 0 = unvisited, 1 = in progress, 2 = done
+    state[ruleId] = 1;
+    for (const auto& alternative : grammar.alternatives[ruleId])
     {
-        rulesList1 << ruleList[i];
-        if (i != ruleList.size() - 1)
+        const auto leftmost = alternative.front();
+        if (state[leftmost] == 1)
         {
-            rulesList1 << " ";
+            grammar.hasLeftCycle = true;
+        }
+        else if (state[leftmost] == 0)
+        {
+            _orderByLeftmostSymbol(leftmost, grammar, state);
         }
     }
-
-    return rulesList1.str();
+    state[ruleId] = 2;
+    grammar.evaluationOrder.push_back(ruleId);
 }
 
-bool matchesRule(string rule, string message, map<uint64_t, string>& rules, map<pair<string, string>, bool>& cachedResults)
+const Grammar compileGrammar(const map<uint64_t, string>& rules)
 {
-    if (DEBUG)
-    {
-        cout << endl << "checking (" << rule << "," << message << ")" << endl;
-    }
+    Grammar grammar;
 
-    const auto cacheKey = pair(rule, message);
-    if (cachedResults.find(cacheKey) != cachedResults.end())
+    uint64_t maxRuleId = 0;
+    for (const auto& [ruleId, ruleStr] : rules)
     {
-        return cachedResults[cacheKey];
-    }
+        maxRuleId = max(maxRuleId, ruleId);
 
-    // base cases
-    if (message.size() == 0)
-    {
-        return false;
+        istringstream ss(ruleStr);
+        string token;
+        while (ss >> token)
+        {
+            if (isdigit(token[0]))
+            {
+                maxRuleId = max<uint64_t>(maxRuleId, stoull(token));
+            }
+        }
     }
 
-    // it is a single rule
-    if (rule.find(' ') == string::npos)
-    {
-        const auto ch = rule[0];
+    const size_t numRules = rules.empty() ? 0 : maxRuleId + 1;
+    grammar.terminals.assign(numRules, 0);
+    grammar.alternatives.assign(numRules, {});
 
-        if (ch == 'a' || ch == 'b')
+    for (const auto& [ruleId, ruleStr] : rules)
+    {
+        if (ruleStr == "a" || ruleStr == "b")
         {
-            // it is a terminal rule
-
-            bool res = message.size() == 1 && message[0] == ch;
-            return res;
+            grammar.terminals[ruleId] = ruleStr[0];
+            continue;
         }
-        else
-        {
-            // it is a recursive rule
-            uint64_t nextRuleId;
-            istringstream ss(rule);
-            ss >> nextRuleId;
 
-            return matchesRule(rules[nextRuleId], message, rules, cachedResults);
+        auto& alternatives = grammar.alternatives[ruleId];
+        alternatives.emplace_back();
+
+        istringstream ss(ruleStr);
+        string token;
+        while (ss >> token)
+        {
+            if (token == "|")
+            {
+                alternatives.emplace_back();
+            }
+            else
+            {
+                alternatives.back().push_back(stoul(token));
+            }
         }
+
+        erase_if(alternatives, [](const auto& alternative) { return alternative.empty(); });
     }
 
-    if (rule.find('|') == string::npos)
+    vector<uint8_t> state(numRules, 0);
+    for (uint32_t ruleId = 0; ruleId < numRules; ++ruleId)
     {
-        // cout << "list of rules (" << rule << ")" << endl;
-
-        // it is a single list of rules
+        if (state[ruleId] == 0)
+        {
+            _orderByLeftmostSymbol(ruleId, grammar, state);
+        }
+    }
 
-        // grab the rules from the list
-        vector<string> rulesIds;
+    return grammar;
+}
 
-        istringstream ruleListSs(rule);
-        string ruleStr;
+// Span recognizer: ends[start][rule] is a bitset of every end position e such that
+// message[start, e) derives from rule. Start positions are filled right to left, so every
+// symbol after the first one in a sequence only looks up rows that are already final; the
+// first symbol looks up the same row, which evaluationOrder takes care of (with a fixed point
+// iteration when the grammar is left recursive).
+class Recognizer
+{
+public:
+    Recognizer(const Grammar& grammar) : _grammar(grammar) {}
 
-        while (getline(ruleListSs, ruleStr, ' '))
+    bool matches(const string& message, const uint32_t startRule)
+    {
+        const size_t n = message.size();
+        if (n == 0 || startRule >= _grammar.terminals.size())
         {
-            rulesIds.emplace_back(ruleStr);
+            return false;
         }
 
-        ostringstream restOfRulesSs;
-        for (size_t i = 1; i < rulesIds.size(); ++i)
+        const size_t numRules = _grammar.terminals.size();
+        _numWords = (n + 1 + 63) / 64;
+        _rowSize = numRules * _numWords;
+        _ends.assign(n * _rowSize, 0);
+        _scratch.resize(2 * _numWords);
+
+        for (size_t start = n; start-- > 0;)
         {
-            restOfRulesSs << rulesIds[i];
-            if (i != rulesIds.size() - 1)
+            bool changed = true;
+            while (changed)
             {
-                restOfRulesSs << " ";
+                changed = false;
+                for (const auto ruleId : _grammar.evaluationOrder)
+                {
+                    changed |= _evaluateRule(message, start, ruleId);
+                }
+                changed &= _grammar.hasLeftCycle;
             }
         }
 
-        // cout << "found number of rules in list= " << rulesIds.size() << endl;
+        return _bits(0, startRule)[n / 64] & (1ull << (n % 64));
+    }
+
+private:
+    uint64_t* _bits(const size_t start, const size_t ruleId)
+    {
+        return _ends.data() + start * _rowSize + ruleId * _numWords;
+    }
 
-        // try to find a message split that would satisfy this list of rules
-        bool matchesSplit = false;
-        for (size_t splitIdx = 1; splitIdx < message.size() && !matchesSplit; ++splitIdx)
+    // Returns true if the end set of ruleId at start gained any positions.
+    bool _evaluateRule(const string& message, const size_t start, const uint32_t ruleId)
+    {
+        uint64_t* target = _bits(start, ruleId);
+
+        const auto terminal = _grammar.terminals[ruleId];
+        if (terminal != 0)
         {
-            // check that the substring up to the splitIdx matches the first rule, recursively check the remainding
-            // of the message against the rest of the rules
-            matchesSplit = matchesSplit ||
-                            (matchesRule(rulesIds[0], message.substr(0, splitIdx), rules, cachedResults) &&
-                            matchesRule(restOfRulesSs.str(), message.substr(splitIdx, message.size() - splitIdx), rules, cachedResults));
+            const uint64_t endBit = 1ull << ((start + 1) % 64);
+            if (message[start] != terminal || (target[(start + 1) / 64] & endBit))
+            {
+                return false;
+            }
+            target[(start + 1) / 64] |= endBit;
+            return true;
         }
 
-        cachedResults[cacheKey] = matchesSplit;
-
-        return matchesSplit;
-    }
-    else
-    {
-        // it is a list of lists of rules
-        smatch match;
-        if (regex_match(rule, match, LIST_OF_LISTS_OF_RULES))
+        bool changed = false;
+        uint64_t* current = _scratch.data();
+        uint64_t* next = _scratch.data() + _numWords;
+        for (const auto& alternative : _grammar.alternatives[ruleId])
         {
-            const auto ruleList1 = cleanRuleList(match[1]);
-            const auto ruleList2 = cleanRuleList(match[2]);
+            copy_n(_bits(start, alternative[0]), _numWords, current);
 
-            bool listsResult = matchesRule(ruleList1, message, rules, cachedResults) ||
-                                matchesRule(ruleList2, message, rules, cachedResults);
+            for (size_t k = 1; k < alternative.size(); ++k)
+            {
+                fill_n(next, _numWords, 0);
+                bool any = false;
+                for (size_t w = 0; w < _numWords; ++w)
+                {
+                    for (uint64_t word = current[w]; word != 0; word &= word - 1)
+                    {
+                        const size_t mid = w * 64 + countr_zero(word);
+                        if (mid >= message.size())
+                        {
+                            continue;
+                        }
+
+                        const uint64_t* midEnds = _bits(mid, alternative[k]);
+                        for (size_t v = 0; v < _numWords; ++v)
+                        {
+                            next[v] |= midEnds[v];
+                        }
+                        any = true;
+                    }
+                }
+
+                swap(current, next);
+                if (!any)
+                {
+                    break;
+                }
+            }
 
-            cachedResults[cacheKey] = listsResult;
-            return listsResult;
+            for (size_t w = 0; w < _numWords; ++w)
+            {
+                const uint64_t added = current[w] & ~target[w];
+                target[w] |= added;
+                changed |= added != 0;
+            }
         }
-        else
+
+        return changed;
+    }
+
+    const Grammar& _grammar;
+    size_t _numWords = 0;
+    size_t _rowSize = 0;
+    vector<uint64_t> _ends;
+    vector<uint64_t> _scratch;
+};
+
+size_t countMatchingMessages(const Grammar& grammar, const vector<string>& messages)
+{
+    vector<uint8_t> matching(messages.size(), 0);
+
+    parallelForChunks(messages.size(), [&](const size_t, const size_t startIdx, const size_t endIdx)
+    {
+        // every worker reuses the table allocations of its own recognizer
+        Recognizer recognizer(grammar);
+
+        for (size_t i = startIdx; i < endIdx; ++i)
         {
-            cout << "Rule " << rule << " did not match list of lists regex!" << endl;
-            exit(1);
+            matching[i] = recognizer.matches(messages[i], 0);
         }
-    }
+    });
 
-    // cout << "why we here? rule=" << rule << endl;
-    return false;
+    return accumulate(matching.begin(), matching.end(), size_t(0));
 }
 
 void part1(map<uint64_t, string>& rules, vector<string>& messages)
 {
-    size_t matchingCount = 0;
-
-    map<pair<string, string>, bool> cachedResults;
+    const auto grammar = compileGrammar(rules);
 
-    for (const auto m : messages)
-    {
-        matchingCount += matchesRule(rules[0], m, rules, cachedResults);
-    }
-
-    cout << matchingCount << endl;
+    cout << countMatchingMessages(grammar, messages) << endl;
 }
 
 void part2(map<uint64_t, string>& rules, vector<string>& messages)
@@ -215,16 +309,10 @@ void part2(map<uint64_t, string>& rules, vector<string>& messages)
     rules[8] = "42 | 42 8";
     rules[11] = "42 31 | 42 11 31";
 
-    size_t matchingCount = 0;
-
-    map<pair<string, string>, bool> cachedResults;
+    const auto grammar = compileGrammar(rules);
 
-    for (const auto m : messages)
-    {
-        matchingCount += matchesRule(rules[0], m, rules, cachedResults);
-    }
-
-    cout << matchingCount << endl;}
+    cout << countMatchingMessages(grammar, messages) << endl;
+}
 
 
 int main(int argc, char **argv)
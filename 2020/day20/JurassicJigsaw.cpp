@@ -5,164 +5,249 @@
 #include <regex>
 #include <numeric>
 #include <map>
+#include <unordered_map>
+#include <array>
+#include <cmath>
+#include <bit>
+#include <optional>
+#include <algorithm>
 
 using namespace std;
 
-#define DEBUG 1
+#define DEBUG 0
 
 const regex TILE_NUM("Tile ([0-9]+):");
 
+const vector<string> SEA_MONSTER = {
+    "                  # ",
+    "#    ##    ##    ###",
+    " #  #  #  #  #  #   ",
+};
 
-struct BorderEncoding
+// Square grid of bits packed into 64-bit words, row by row (bit j of a row is column j).
+struct BitGrid
 {
-    BorderEncoding() {}
-    BorderEncoding(uint16_t e1, uint16_t e2) : encoding1(e1), encoding2(e2) {}
+    BitGrid() {}
+    BitGrid(size_t size) : n(size), wordsPerRow((size + 63) / 64), bits(size * ((size + 63) / 64), 0) {}
 
-    uint16_t encoding1 = 0;
-    uint16_t encoding2 = 0;
+    size_t n = 0;
+    size_t wordsPerRow = 0;
+    vector<uint64_t> bits;
 
-    bool operator==(const BorderEncoding& border) const
+    bool get(const size_t row, const size_t col) const
     {
-        return  encoding1 == border.encoding1 ||
-                encoding1 == border.encoding2 ||
-                encoding2 == border.encoding1 ||
-                encoding2 == border.encoding2;
+        return (bits[row * wordsPerRow + col / 64] >> (col % 64)) & 1;
     }
-};
-
-struct Tile
-{
-    Tile() {}
-    Tile(uint32_t tileId) : id(tileId) {}
 
-    uint32_t id = 0;
-    vector<uint32_t> borders;
-    vector<string> raw;
+    void set(const size_t row, const size_t col)
+    {
+        bits[row * wordsPerRow + col / 64] |= 1ull << (col % 64);
+    }
 
-    void generateBorderEncodings()
+    // bits [col, col + width) of the given row, with width <= 64
+    uint64_t window(const size_t row, const size_t col, const size_t width) const
     {
-        if (raw.size() == 0)
+        const uint64_t* rowBits = bits.data() + row * wordsPerRow;
+        const size_t offset = col % 64;
+
+        uint64_t w = rowBits[col / 64] >> offset;
+        if (offset != 0 && offset + width > 64)
         {
-            return;
+            w |= rowBits[col / 64 + 1] << (64 - offset);
         }
 
-        const auto n = raw.size();
+        return width == 64 ? w : w & ((1ull << width) - 1);
+    }
 
-        vector<vector<bool>> binaryBorders(4, vector<bool>(n));
+    // ORs the low width bits of value into bits [col, col + width) of the given row, with width <= 64
+    void setWindow(const size_t row, const size_t col, const uint64_t value, const size_t width)
+    {
+        uint64_t* rowBits = bits.data() + row * wordsPerRow;
+        const size_t offset = col % 64;
+        const uint64_t masked = width == 64 ? value : value & ((1ull << width) - 1);
 
-        for (size_t i = 0; i < n; ++i)
+        rowBits[col / 64] |= masked << offset;
+        if (offset != 0 && offset + width > 64)
         {
-            // top
-            binaryBorders[0][i] = raw[0][i] == '#' ? 1 : 0;
-            // right
-            binaryBorders[1][i] = raw[i][n-1] == '#' ? 1 : 0;
-            // left
-            binaryBorders[2][i] = raw[i][0] == '#' ? 1 : 0;
-            // bottom
-            binaryBorders[3][i] = raw[n-1][i] == '#' ? 1 : 0;
+            rowBits[col / 64 + 1] |= masked >> (64 - offset);
         }
+    }
 
-        for (const auto& b : binaryBorders)
+    size_t count() const
+    {
+        size_t total = 0;
+        for (const auto word : bits)
         {
-            const uint32_t e1 = encoding(b, false);
-            const uint32_t e2 = encoding(b, true);
+            total += popcount(word);
+        }
+        return total;
+    }
+};
 
-            borders.push_back(e1 * e2);
+uint64_t reverseBits(uint64_t word)
+{
+    word = ((word >> 1) & 0x5555555555555555ull) | ((word & 0x5555555555555555ull) << 1);
+    word = ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((word & 0x0F0F0F0F0F0F0F0Full) << 4);
+    word = ((word >> 8) & 0x00FF00FF00FF00FFull) | ((word & 0x00FF00FF00FF00FFull) << 8);
+    word = ((word >> 16) & 0x0000FFFF0000FFFFull) | ((word & 0x0000FFFF0000FFFFull) << 16);
+    return (word >> 32) | (word << 32);
+}
+
+// In place transpose of a 64x64 bit block (bit j of block[i] is row i, column j): the off-diagonal
+// quadrants are swapped at every scale, 32x32 blocks first, down to single bits.
+void transposeBlock(array<uint64_t, 64>& block)
+{
+    uint64_t mask = 0x00000000FFFFFFFFull;
+    for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j)
+    {
+        for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            const uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+            block[k] ^= t << j;
+            block[k | j] ^= t;
         }
     }
+}
 
-    private:
-        uint16_t encoding(const vector<bool>& border, bool reverse)
+BitGrid transposed(const BitGrid& grid)
+{
+    BitGrid result(grid.n);
+
+    array<uint64_t, 64> block;
+    for (size_t blockRow = 0; blockRow < grid.wordsPerRow; ++blockRow)
+    {
+        for (size_t blockCol = 0; blockCol < grid.wordsPerRow; ++blockCol)
         {
-            if (reverse)
+            for (size_t i = 0; i < 64; ++i)
             {
-                return static_cast<uint16_t>(
-                    accumulate(
-                        border.rbegin(),
-                        border.rend(),
-                        static_cast<uint16_t>(0),
-                        [](const uint16_t res, const uint16_t e)
-                        {
-                            return (res << 1) + e;
-                        }));
+                const size_t row = blockRow * 64 + i;
+                block[i] = row < grid.n ? grid.bits[row * grid.wordsPerRow + blockCol] : 0;
             }
 
-            return static_cast<uint16_t>(
-                accumulate(
-                    border.begin(),
-                    border.end(),
-                    static_cast<uint16_t>(0),
-                    [](const uint16_t res, const uint16_t e)
-                    {
-                        return (res << 1) + e;
-                    }));
+            transposeBlock(block);
+
+            for (size_t i = 0; i < 64 && blockCol * 64 + i < grid.n; ++i)
+            {
+                result.bits[(blockCol * 64 + i) * result.wordsPerRow + blockRow] = block[i];
+            }
         }
-};
+    }
 
+    return result;
+}
 
-uint16_t encoding(const vector<bool>& border, const bool reverse)
+// column c becomes column n - 1 - c: every row is bit reversed over its whole words, then shifted
+// back down by the padding above column n - 1
+BitGrid mirroredColumns(const BitGrid& grid)
 {
-    if (reverse)
+    BitGrid result(grid.n);
+    const size_t numWords = grid.wordsPerRow;
+    const size_t padding = numWords * 64 - grid.n;
+
+    for (size_t row = 0; row < grid.n; ++row)
     {
-        return static_cast<uint16_t>(
-            accumulate(
-                border.rbegin(),
-                border.rend(),
-                static_cast<uint16_t>(0),
-                [](const uint16_t res, const uint16_t e)
-                {
-                    return (res << 1) + e;
-                }));
-    }
+        const uint64_t* rowBits = grid.bits.data() + row * numWords;
+        uint64_t* resultBits = result.bits.data() + row * numWords;
+
+        for (size_t w = 0; w < numWords; ++w)
+        {
+            resultBits[w] = reverseBits(rowBits[numWords - 1 - w]);
+        }
 
-    return static_cast<uint16_t>(
-        accumulate(
-            border.begin(),
-            border.end(),
-            static_cast<uint16_t>(0),
-            [](const uint16_t res, const uint16_t e)
+        if (padding != 0)
+        {
+            for (size_t w = 0; w < numWords; ++w)
             {
-                return (res << 1) + e;
-            }));
+                const uint64_t high = w + 1 < numWords ? resultBits[w + 1] << (64 - padding) : 0;
+                resultBits[w] = (resultBits[w] >> padding) | high;
+            }
+        }
+    }
+
+    return result;
 }
 
-vector<uint32_t> generateBorderEncodings(const vector<string>& rawTile)
+// row r becomes row n - 1 - r, moving whole packed rows
+BitGrid mirroredRows(const BitGrid& grid)
 {
-    if (rawTile.size() == 0)
+    BitGrid result(grid.n);
+    for (size_t row = 0; row < grid.n; ++row)
     {
-        return vector<uint32_t>();
+        copy_n(grid.bits.begin() + row * grid.wordsPerRow, grid.wordsPerRow,
+               result.bits.begin() + (grid.n - 1 - row) * grid.wordsPerRow);
     }
 
-    const auto n = rawTile.size();
+    return result;
+}
 
-    vector<vector<bool>> binaryBorders(4, vector<bool>(n));
-    for (size_t i = 0; i < n; ++i)
+// The 8 dihedral orientations, as permutations of the packed rows and bits: bit 2 transposes, then
+// bit 0 mirrors the columns and bit 1 mirrors the rows.
+BitGrid orient(const BitGrid& grid, const size_t orientation)
+{
+    BitGrid result = orientation & 4 ? transposed(grid) : grid;
+    if (orientation & 1)
+    {
+        result = mirroredColumns(result);
+    }
+    if (orientation & 2)
     {
-        // top
-        binaryBorders[0][i] = rawTile[0][i] == '#' ? 1 : 0;
-        // right
-        binaryBorders[1][i] = rawTile[i][n-1] == '#' ? 1 : 0;
-        // left
-        binaryBorders[2][i] = rawTile[i][0] == '#' ? 1 : 0;
-        // bottom
-        binaryBorders[3][i] = rawTile[n-1][i] == '#' ? 1 : 0;
+        result = mirroredRows(result);
     }
 
-    vector<uint32_t> borderEncodings;
-    for (const auto& b : binaryBorders)
+    return result;
+}
+
+enum Side
+{
+    Top = 0,
+    Right,
+    Bottom,
+    Left,
+};
+
+struct Tile
+{
+    uint32_t id = 0;
+    BitGrid pixels;
+};
+
+// tiles are at most this wide, so that a whole edge fits in one 64-bit code, and at least wide
+// enough to keep some pixels once their borders are removed
+constexpr size_t kMinTileSize = 3;
+constexpr size_t kMaxTileSize = 64;
+
+// Edge code of a tile side, read left to right (top/bottom) or top to bottom (left/right).
+uint64_t edgeCode(const BitGrid& grid, const Side side)
+{
+    const size_t last = grid.n - 1;
+
+    if (side == Top || side == Bottom)
     {
-        const uint32_t e1 = encoding(b, false);
-        const uint32_t e2 = encoding(b, true);
+        return grid.window(side == Top ? 0 : last, 0, grid.n);
+    }
 
-        borderEncodings.push_back(e1 * e2);
+    uint64_t code = 0;
+    for (size_t i = 0; i < grid.n; ++i)
+    {
+        code |= static_cast<uint64_t>(grid.get(i, side == Right ? last : 0)) << i;
     }
 
-    return borderEncodings;
+    return code;
 }
 
-void part1(istream& inputFile)
+// An edge matches its neighbor either as is or reversed, depending on the orientations.
+uint64_t canonicalEdgeCode(const uint64_t code, const size_t n)
+{
+    const uint64_t reversed = reverseBits(code) >> (64 - n);
+    return min(code, reversed);
+}
+
+typedef unordered_map<uint64_t, vector<size_t>> edge_index_t;  // canonical edge code -> tile indices
+
+vector<Tile> readTiles(istream& inputFile)
 {
-    map<uint32_t, vector<uint32_t>> borderEncodingToTiles;
+    vector<Tile> tiles;
     while (!inputFile.eof())
     {
         string line;
@@ -171,9 +256,8 @@ void part1(istream& inputFile)
         smatch match;
         if (regex_match(line, match, TILE_NUM))
         {
-            uint32_t tileId;
-            istringstream ss(match[1].str());
-            ss >> tileId;
+            Tile tile;
+            tile.id = stoul(match[1].str());
 
             // read the actual tile
             vector<string> rawTile;
@@ -187,55 +271,260 @@ void part1(istream& inputFile)
                 }
             }
 
-            const auto borderEncodings = generateBorderEncodings(rawTile);
+            const size_t n = rawTile.size();
+            const bool isSquare = all_of(rawTile.begin(), rawTile.end(), [n](const string& tileRow)
+            {
+                return tileRow.size() == n;
+            });
+            if (n < kMinTileSize || n > kMaxTileSize || !isSquare)
+            {
+                cout << "Tile " << tile.id << " is not a square of " << kMinTileSize << " to " << kMaxTileSize << " pixels" << endl;
+                exit(1);
+            }
 
-            for (const auto& encoding : borderEncodings)
+            tile.pixels = BitGrid(n);
+            for (size_t row = 0; row < n; ++row)
             {
-                if (borderEncodingToTiles.find(encoding) == borderEncodingToTiles.end())
+                for (size_t col = 0; col < rawTile[row].size(); ++col)
                 {
-                    borderEncodingToTiles[encoding] = vector<uint32_t>();
+                    if (rawTile[row][col] == '#')
+                    {
+                        tile.pixels.set(row, col);
+                    }
                 }
-
-                borderEncodingToTiles[encoding].push_back(tileId);
             }
+
+            tiles.push_back(tile);
         }
     }
 
-    map<uint32_t, size_t> tileIdToMissingNeighborCount;
-    for (const auto [_, tileIds] : borderEncodingToTiles)
+    return tiles;
+}
+
+edge_index_t buildEdgeIndex(const vector<Tile>& tiles)
+{
+    edge_index_t edgeIndex;
+    for (size_t tileIdx = 0; tileIdx < tiles.size(); ++tileIdx)
     {
-        if (tileIds.size() == 1)
+        const auto& pixels = tiles[tileIdx].pixels;
+        for (const auto side : {Top, Right, Bottom, Left})
         {
-            tileIdToMissingNeighborCount[tileIds[0]] += 1;
+            edgeIndex[canonicalEdgeCode(edgeCode(pixels, side), pixels.n)].push_back(tileIdx);
         }
     }
 
     if (DEBUG)
     {
-        for (const auto [borderEncoding, tileIds] : borderEncodingToTiles)
+        for (const auto& [code, tileIndices] : edgeIndex)
         {
-            cout << borderEncoding << " : ( ";
-            for (const auto& tileId : tileIds)
+            cout << code << " : ( ";
+            for (const auto& tileIdx : tileIndices)
             {
-                cout << tileId << " ";
+                cout << tiles[tileIdx].id << " ";
             }
             cout << ")" << endl;
         }
+    }
+
+    return edgeIndex;
+}
+
+bool isOuterEdge(const BitGrid& pixels, const Side side, const edge_index_t& edgeIndex)
+{
+    return edgeIndex.at(canonicalEdgeCode(edgeCode(pixels, side), pixels.n)).size() == 1;
+}
+
+size_t countOuterEdges(const Tile& tile, const edge_index_t& edgeIndex)
+{
+    size_t outerEdges = 0;
+    for (const auto side : {Top, Right, Bottom, Left})
+    {
+        outerEdges += isOuterEdge(tile.pixels, side, edgeIndex);
+    }
+    return outerEdges;
+}
+
+// the other tile sharing the given edge, if any
+optional<size_t> findNeighbor(const size_t tileIdx, const uint64_t code, const size_t n, const edge_index_t& edgeIndex)
+{
+    for (const auto otherIdx : edgeIndex.at(canonicalEdgeCode(code, n)))
+    {
+        if (otherIdx != tileIdx)
+        {
+            return otherIdx;
+        }
+    }
+    return nullopt;
+}
 
-        // cout << endl;
+// Places the tiles row by row starting from a corner, looking up every next tile through the edge
+// index and trying its 8 orientations; returns the assembled image without the tile borders.
+optional<BitGrid> assembleImage(const vector<Tile>& tiles, const edge_index_t& edgeIndex)
+{
+    const size_t side = llround(sqrt(tiles.size()));
+    if (side * side != tiles.size())
+    {
+        return nullopt;
+    }
 
-        // for (const auto [tileId, missingNeighborCount] : tileIdToMissingNeighborCount)
-        // {
-        //     cout << tileId << " : " << missingNeighborCount << endl;
-        // }
+    const size_t cornerIdx = distance(tiles.begin(), find_if(tiles.begin(), tiles.end(), [&](const Tile& tile)
+    {
+        return countOuterEdges(tile, edgeIndex) == 2;
+    }));
+    if (cornerIdx == tiles.size())
+    {
+        return nullopt;
     }
 
+    const size_t n = tiles.front().pixels.n;
+    const size_t inner = n - 2;
+
+    vector<size_t> placedTiles(side * side);
+    vector<BitGrid> placedPixels(side * side);
+
+    for (size_t orientation = 0; orientation < 8; ++orientation)
+    {
+        const auto pixels = orient(tiles[cornerIdx].pixels, orientation);
+        if (isOuterEdge(pixels, Top, edgeIndex) && isOuterEdge(pixels, Left, edgeIndex))
+        {
+            placedTiles[0] = cornerIdx;
+            placedPixels[0] = pixels;
+            break;
+        }
+    }
+
+    for (size_t pos = 1; pos < side * side; ++pos)
+    {
+        const size_t row = pos / side;
+        const size_t col = pos % side;
+
+        // match against the left neighbor, or the one above at the start of a row
+        const size_t anchorPos = col > 0 ? pos - 1 : pos - side;
+        const Side anchorSide = col > 0 ? Right : Bottom;
+        const Side matchingSide = col > 0 ? Left : Top;
+
+        const auto anchorCode = edgeCode(placedPixels[anchorPos], anchorSide);
+        const auto neighborIdx = findNeighbor(placedTiles[anchorPos], anchorCode, n, edgeIndex);
+        if (!neighborIdx)
+        {
+            return nullopt;
+        }
+
+        bool placed = false;
+        for (size_t orientation = 0; orientation < 8 && !placed; ++orientation)
+        {
+            const auto pixels = orient(tiles[*neighborIdx].pixels, orientation);
+            if (edgeCode(pixels, matchingSide) != anchorCode)
+            {
+                continue;
+            }
+            if (col > 0 && row > 0 && edgeCode(pixels, Top) != edgeCode(placedPixels[pos - side], Bottom))
+            {
+                continue;
+            }
+
+            placedTiles[pos] = *neighborIdx;
+            placedPixels[pos] = pixels;
+            placed = true;
+        }
+
+        if (!placed)
+        {
+            return nullopt;
+        }
+    }
+
+    BitGrid image(side * inner);
+    for (size_t pos = 0; pos < side * side; ++pos)
+    {
+        const size_t rowOffset = (pos / side) * inner;
+        const size_t colOffset = (pos % side) * inner;
+        for (size_t row = 0; row < inner; ++row)
+        {
+            image.setWindow(rowOffset + row, colOffset, placedPixels[pos].window(row + 1, 1, inner), inner);
+        }
+    }
+
+    return image;
+}
+
+// Scans every orientation of the image for sea monsters, matching each monster row as a bitmask
+// against a window of the image row; returns the number of '#' that are not part of any monster.
+optional<size_t> waterRoughness(const BitGrid& image)
+{
+    const size_t monsterH = SEA_MONSTER.size();
+    const size_t monsterW = SEA_MONSTER.front().size();
+
+    vector<uint64_t> monsterMasks(monsterH, 0);
+    for (size_t row = 0; row < monsterH; ++row)
+    {
+        for (size_t col = 0; col < monsterW; ++col)
+        {
+            if (SEA_MONSTER[row][col] == '#')
+            {
+                monsterMasks[row] |= 1ull << col;
+            }
+        }
+    }
+
+    if (image.n < monsterH || image.n < monsterW)
+    {
+        return nullopt;
+    }
+
+    for (size_t orientation = 0; orientation < 8; ++orientation)
+    {
+        const auto oriented = orient(image, orientation);
+
+        BitGrid monsterPixels(image.n);
+        size_t numMonsters = 0;
+        for (size_t row = 0; row + monsterH <= image.n; ++row)
+        {
+            for (size_t col = 0; col + monsterW <= image.n; ++col)
+            {
+                bool isMonster = true;
+                for (size_t i = 0; i < monsterH && isMonster; ++i)
+                {
+                    isMonster = (oriented.window(row + i, col, monsterW) & monsterMasks[i]) == monsterMasks[i];
+                }
+
+                if (!isMonster)
+                {
+                    continue;
+                }
+
+                numMonsters += 1;
+                for (size_t i = 0; i < monsterH; ++i)
+                {
+                    for (uint64_t mask = monsterMasks[i]; mask != 0; mask &= mask - 1)
+                    {
+                        monsterPixels.set(row + i, col + countr_zero(mask));
+                    }
+                }
+            }
+        }
+
+        if (numMonsters > 0)
+        {
+            return oriented.count() - monsterPixels.count();
+        }
+    }
+
+    return nullopt;
+}
+
+void part1(istream& inputFile)
+{
+    const auto tiles = readTiles(inputFile);
+    const auto edgeIndex = buildEdgeIndex(tiles);
+
+    // corners are the only tiles with two edges no other tile shares
     uint64_t prod = 1;
-    for (const auto [tileId, missingNeighborCount] : tileIdToMissingNeighborCount)
+    for (const auto& tile : tiles)
     {
-        if (missingNeighborCount == 2)
+        if (countOuterEdges(tile, edgeIndex) == 2)
         {
-            prod *= tileId;
+            prod *= tile.id;
         }
     }
 
@@ -244,12 +533,24 @@ void part1(istream& inputFile)
 
 void part2(istream& inputFile)
 {
-    return;
-    while (!inputFile.eof())
+    const auto tiles = readTiles(inputFile);
+    const auto edgeIndex = buildEdgeIndex(tiles);
+
+    const auto image = assembleImage(tiles, edgeIndex);
+    if (!image)
     {
-        string line;
-        getline(inputFile, line);
+        cout << "Could not assemble the image!" << endl;
+        return;
     }
+
+    const auto roughness = waterRoughness(*image);
+    if (!roughness)
+    {
+        cout << "No sea monsters found!" << endl;
+        return;
+    }
+
+    cout << *roughness << endl;
 }
 
 
@@ -276,4 +577,4 @@ int main(int argc, char **argv)
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <unordered_map>
+
+#include "../../util/LinearRecurrence.h"
 
 using namespace std;
+using namespace aoc::util::recurrence;
+using namespace aoc::util::int128;
 
 #define MAX_DAYS_PART1 80
 #define MAX_DAYS_PART2 256
@@ -26,57 +29,47 @@ void print(const vector<size_t>& states, const size_t maxPrintCount = -1)
     cout << endl;
 }
 
-size_t getNumAncestors(const size_t fishTimer, const size_t kMaxDays, unordered_map<size_t, size_t>& timerToAncestors)
+// Fish are counted per timer bucket: every day each bucket moves one timer down, and the fish
+// at timer 0 reset to NEW_CHILD_INTERVAL - 1 while producing the same amount of new children.
+const LinearRecurrence getPopulationRecurrence()
 {
-    // if we cached the result for this timer, just return it and we are done
-    const auto& it = timerToAncestors.find(fishTimer);
-    if (it != timerToAncestors.end())
-    {
-        return it->second;
-    }
-
-    // terminal cases
-    if (fishTimer >= kMaxDays)
+    LinearRecurrence recurrence(NEW_CHILD_TIMER_VALUE + 1);
+    for (size_t timer = 1; timer <= NEW_CHILD_TIMER_VALUE; ++timer)
     {
-        // can not produce any children in the timeframe
-        return 0;
+        recurrence.addTransition(timer, timer - 1);
     }
+    recurrence.addTransition(0, NEW_CHILD_INTERVAL - 1);
+    recurrence.addTransition(0, NEW_CHILD_TIMER_VALUE);
 
-    // we didn't find the ancestor count for the current fish timer, and the current fish can produce at least 1 ancestor
-    // so we need to calculate how many and update the cache...
-
-    // current fish will generate at least 1 (since fishTimer + 1 < kMaxDays) + the amount of times the remainder is
-    // divisible by NEW_CHILD_INTERVAL
-    // we subtract the -1 because it will take an additional day to have the child born, after the fishTimer gets to 0
-    const size_t childrenFishTimers = 1 + (kMaxDays - fishTimer - 1) / NEW_CHILD_INTERVAL;
+    return recurrence;
+}
 
-    size_t numAncestors = childrenFishTimers; // we know how many immediate children fish this fish is going to generate
-                                              // so add them to the total from now
+uint128_t getPopulationAfterDays(const vector<size_t>& fishTimers, const size_t kMaxDays)
+{
+    const auto recurrence = getPopulationRecurrence();
 
-    // precalculate the child timer (from present to when it will be born) and add them to the children vector
-    size_t timerOffset = fishTimer + 1; // we start when the first child would be born
-    size_t generatedChild = 0;
-    while (generatedChild < childrenFishTimers)
+    vector<uint128_t> timerCounts(recurrence.numStates(), 0);
+    for (const auto& fishTimer : fishTimers)
     {
-        // we compute the child timer (from present to when it will be born) the following way: a + 1 + b, where:
-        // a  = the time offset (in days) when the current fish (parent) would reach 0
-        // +1 = the next day after the offset, i.e. when the child actually gets born
-        // b  = the actual timer the child will start with when it will be born
-        const size_t childTimer = timerOffset + NEW_CHILD_TIMER_VALUE;
-
-        // update the timer offset with the number of days it will take the current fish to create a new fish
-        timerOffset += NEW_CHILD_INTERVAL;
+        timerCounts[fishTimer] += 1;
+    }
 
-        // recursively calculate the number of ancestors for this child
-        numAncestors += getNumAncestors(childTimer, kMaxDays, timerToAncestors);
+    const auto finalCounts = recurrence.advance(timerCounts, kMaxDays);
 
-        generatedChild += 1;
+    uint128_t totalFish = 0;
+    bool isOverflowed = !finalCounts;
+    for (const auto& count : finalCounts.value_or(vector<uint128_t>{}))
+    {
+        isOverflowed |= __builtin_add_overflow(totalFish, count, &totalFish);
     }
 
-    // update the cache
-    timerToAncestors.insert({fishTimer, numAncestors});
+    if (isOverflowed)
+    {
+        cout << "The fish population does not fit in 128 bits after " << kMaxDays << " days!" << endl;
+        exit(1);
+    }
 
-    return numAncestors;
+    return totalFish;
 }
 
 void part1(istream& inputFile)
@@ -84,7 +77,6 @@ void part1(istream& inputFile)
     constexpr size_t kMaxDays = MAX_DAYS_PART1;
 
     vector<size_t> fishTimers;
-    unordered_map<size_t, size_t> timerToAncestors;
 
     while (!inputFile.eof())
     {
@@ -94,13 +86,7 @@ void part1(istream& inputFile)
         fishTimers.push_back(stoi(numStr));
     }
 
-    size_t totalFish = fishTimers.size(); // start with initial population
-    for (const auto& fishTimer : fishTimers)
-    {
-        totalFish += getNumAncestors(fishTimer, kMaxDays, timerToAncestors);
-    }
-
-    cout << totalFish << endl;
+    cout << toString(getPopulationAfterDays(fishTimers, kMaxDays)) << endl;
 }
 
 void part2(istream& inputFile)
@@ -108,7 +94,6 @@ void part2(istream& inputFile)
     constexpr size_t kMaxDays = MAX_DAYS_PART2;
 
     vector<size_t> fishTimers;
-    unordered_map<size_t, size_t> timerToAncestors;
 
     while (!inputFile.eof())
     {
@@ -118,13 +103,7 @@ void part2(istream& inputFile)
         fishTimers.push_back(stoi(numStr));
     }
 
-    size_t totalFish = fishTimers.size(); // start with initial population
-    for (const auto& fishTimer : fishTimers)
-    {
-        totalFish += getNumAncestors(fishTimer, kMaxDays, timerToAncestors);
-    }
-
-    cout << totalFish << endl;
+    cout << toString(getPopulationAfterDays(fishTimers, kMaxDays)) << endl;
 }
 
 int main(int argc, char **argv)
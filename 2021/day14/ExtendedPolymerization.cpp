@@ -6,9 +6,12 @@
 #include <algorithm>
 #include <utility>
 #include <cmath>
-#include <tuple>
+
+#include "../../util/LinearRecurrence.h"
 
 using namespace std;
+using namespace aoc::util::recurrence;
+using namespace aoc::util::int128;
 
 #define NUM_STEPS_PART_1 10
 #define NUM_STEPS_PART_2 40
@@ -33,26 +36,7 @@ struct duplex_element_t_hash
 
 typedef unordered_map<duplex_element_t, char, duplex_element_t_hash, duplex_element_t_equal> pair_map_t;
 
-typedef tuple<size_t, char, char> cache_key_t;
-
-struct cache_key_t_equal
-{
-    bool operator()(const cache_key_t& k1, const cache_key_t& k2) const
-    {
-        return (get<0>(k1) == get<0>(k2)) && (get<1>(k1) == get<1>(k2)) && (get<2>(k1) == get<2>(k2));
-    }
-};
-
-struct cache_key_t_hash
-{
-    size_t operator()(const cache_key_t& k) const
-    {
-        return get<0>(k) ^ get<1>(k) ^ get<2>(k);
-    }
-};
-
-typedef unordered_map<char, size_t> element_counts_t;
-typedef unordered_map<cache_key_t, element_counts_t, cache_key_t_hash, cache_key_t_equal> iterations_counts_t;
+typedef unordered_map<char, uint128_t> element_counts_t;
 
 
 const vector<duplex_element_t> getDuplexElements(const vector<char>& polymer)
@@ -130,98 +114,89 @@ void runPolyGrow(
 }
 
 
-void mergeDicts(const element_counts_t& elemCountsSrc, element_counts_t& elemCountsDst)
+// The polymer is tracked as a count vector over element pairs: a pair AB with the insertion
+// rule AB -> C becomes the pairs AC and CB on the next step. Every element is the first one of
+// exactly one pair, except for the last template element which never changes.
+void runPolyGrowMatrix(
+    const string& polyTemplate,
+    const pair_map_t& pairMap,
+    element_counts_t& elementCounts,
+    const size_t kNumIterations)
 {
-    if (elemCountsSrc.empty())
+    vector<char> elements(polyTemplate.begin(), polyTemplate.end());
+    for (const auto& [duplex, insertionElement] : pairMap)
     {
-        return;
+        elements.insert(elements.end(), {duplex.first, duplex.second, insertionElement});
     }
+    sort(elements.begin(), elements.end());
+    elements.erase(unique(elements.begin(), elements.end()), elements.end());
 
-    for (const auto& elemCounts : elemCountsSrc)
+    const size_t numElements = elements.size();
+    const auto getElementIdx = [&elements](const char element)
+    {
+        return static_cast<size_t>(lower_bound(elements.begin(), elements.end(), element) - elements.begin());
+    };
+    const auto getPairIdx = [&](const char first, const char second)
     {
-        const auto k = elemCounts.first;
-        const auto v = elemCounts.second;
+        return getElementIdx(first) * numElements + getElementIdx(second);
+    };
 
-        const auto& it = elemCountsDst.find(k);
-        if (it == elemCountsDst.end())
-        {
-            elemCountsDst.insert({k, v});
-        }
-        else
+    LinearRecurrence recurrence(numElements * numElements);
+    for (const auto first : elements)
+    {
+        for (const auto second : elements)
         {
-            it->second += v;
+            const auto pairIdx = getPairIdx(first, second);
+            const auto& it = pairMap.find({first, second});
+            if (it == pairMap.end())
+            {
+                recurrence.addTransition(pairIdx, pairIdx);
+                continue;
+            }
+
+            recurrence.addTransition(pairIdx, getPairIdx(first, it->second));
+            recurrence.addTransition(pairIdx, getPairIdx(it->second, second));
         }
     }
-}
-
-const element_counts_t getCountsForIterations(
-    const duplex_element_t& duplexElement,
-    const pair_map_t& pairMap,
-    iterations_counts_t& iterationsCountsCache,
-    const size_t kRemainingIterations)
-{
-    const auto cacheKey = cache_key_t{kRemainingIterations, duplexElement.first, duplexElement.second};
 
-    // check if we have this value pre-calculated, so we can exit fast
-    const auto& it = iterationsCountsCache.find(cacheKey);
-    if (it != iterationsCountsCache.end())
+    vector<uint128_t> pairCounts(recurrence.numStates(), 0);
+    for (size_t i = 0; i + 1 < polyTemplate.size(); ++i)
     {
-        return it->second;
+        pairCounts[getPairIdx(polyTemplate[i], polyTemplate[i + 1])] += 1;
     }
 
-    // base case, when we can simply calculate and return directly
-    if (kRemainingIterations == 0)
-    {
-        element_counts_t result;
-        result[duplexElement.first] += 1;
-        result[duplexElement.second] += 1;
+    const auto finalPairCounts = recurrence.advance(pairCounts, kNumIterations);
 
-        return result;
+    // every element is counted as the first of its pair, except the last one of the polymer
+    vector<uint128_t> counts(numElements, 0);
+    bool isOverflowed = !finalPairCounts;
+    if (finalPairCounts)
+    {
+        for (size_t pairIdx = 0; pairIdx < finalPairCounts->size(); ++pairIdx)
+        {
+            auto& count = counts[pairIdx / numElements];
+            isOverflowed |= __builtin_add_overflow(count, (*finalPairCounts)[pairIdx], &count);
+        }
+    }
+    if (!polyTemplate.empty())
+    {
+        auto& count = counts[getElementIdx(polyTemplate.back())];
+        isOverflowed |= __builtin_add_overflow(count, 1, &count);
     }
 
-    // expand the current duplex and calculate the counts for its corresponding parts, recursively
-    const auto insertionElement = pairMap.at(duplexElement);
-    const auto leftDuplex = duplex_element_t{duplexElement.first, insertionElement};
-    const auto rightDuplex = duplex_element_t{insertionElement, duplexElement.second};
-
-    const auto leftCounts = getCountsForIterations(leftDuplex, pairMap, iterationsCountsCache, kRemainingIterations - 1);
-    const auto rightCounts = getCountsForIterations(rightDuplex, pairMap, iterationsCountsCache, kRemainingIterations - 1);
-
-    auto elementCounts = leftCounts;
-    mergeDicts(rightCounts, elementCounts);
-    elementCounts[insertionElement] -= 1; // we double counted the middle element
-
-    // update cache
-    iterationsCountsCache.insert({cacheKey, elementCounts});
-
-    return elementCounts;
-}
+    if (isOverflowed)
+    {
+        cout << "The element counts do not fit in 128 bits after " << kNumIterations << " steps!" << endl;
+        exit(1);
+    }
 
-void runPolyGrowFast(
-    const string& polyTemplate,
-    const pair_map_t& pairMap,
-    element_counts_t& elementCounts,
-    const size_t kNumIterations)
-{
-    const auto polymerVect = vector<char>(polyTemplate.begin(), polyTemplate.end());
-    iterations_counts_t iterationsCountsCache;
-    const auto duplexes = getDuplexElements(polymerVect);
-    for (size_t i = 0; i < duplexes.size(); ++i)
+    for (size_t elementIdx = 0; elementIdx < numElements; ++elementIdx)
     {
-        const auto& duplex = duplexes[i];
-        const auto resultCounts = getCountsForIterations(duplex, pairMap, iterationsCountsCache, kNumIterations);
-        mergeDicts(resultCounts, elementCounts);
-        if (i != duplexes.size() - 1)
+        if (counts[elementIdx] != 0)
         {
-            elementCounts[duplex.second] -= 1; // subtract the element that will be double counted by the next duplex
+            elementCounts[elements[elementIdx]] += counts[elementIdx];
         }
     }
-
-    // DEBUG
-    // for (const auto& elemCounts : elementCounts)
-    // {
-    //     cout << elemCounts.first << ": " << elemCounts.second << endl;
-    // }
 }
 
 void part1(istream& inputFile)
@@ -230,7 +205,7 @@ void part1(istream& inputFile)
 
     string polyTemplate = "";
     pair_map_t pairMap;
-    unordered_map<char, size_t> elementCounts;
+    element_counts_t elementCounts;
 
     bool readTemplate = false;
     while (!inputFile.eof())
@@ -268,7 +243,7 @@ void part1(istream& inputFile)
         }
     }
 
-    runPolyGrowFast(polyTemplate, pairMap, elementCounts, NUM_STEPS_PART_1);
+    runPolyGrowMatrix(polyTemplate, pairMap, elementCounts, NUM_STEPS_PART_1);
     const auto minOccurences = min_element(
         elementCounts.begin(),
         elementCounts.end(),
@@ -285,7 +260,7 @@ void part1(istream& inputFile)
         });
 
     const auto result = maxOccurences->second - minOccurences->second;
-    cout << result << endl;
+    cout << toString(result) << endl;
 }
 
 void part2(istream& inputFile)
@@ -294,7 +269,7 @@ void part2(istream& inputFile)
 
     string polyTemplate = "";
     pair_map_t pairMap;
-    unordered_map<char, size_t> elementCounts;
+    element_counts_t elementCounts;
 
     bool readTemplate = false;
     while (!inputFile.eof())
@@ -332,7 +307,7 @@ void part2(istream& inputFile)
         }
     }
 
-    runPolyGrowFast(polyTemplate, pairMap, elementCounts, NUM_STEPS_PART_2);
+    runPolyGrowMatrix(polyTemplate, pairMap, elementCounts, NUM_STEPS_PART_2);
     const auto minOccurences = min_element(
         elementCounts.begin(),
         elementCounts.end(),
@@ -349,7 +324,7 @@ void part2(istream& inputFile)
         });
 
     const auto result = maxOccurences->second - minOccurences->second;
-    cout << result << endl;
+    cout << toString(result) << endl;
 }
 
 
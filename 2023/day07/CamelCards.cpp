@@ -7,55 +7,16 @@
 #include <sstream>
 #include <cstdint>
 #include <vector>
-#include <regex>
-#include <unordered_map>
 #include <array>
-#include <set>
+#include <algorithm>
 #include <utility>
-#include <map>
 
 using namespace std;
 
-regex HAND_RX("([AKQJT2-9]+) ([0-9]+)");
+const size_t kHandSize = 5;
 
-const size_t kDeckSize = 13;
-const char kJokerCard = 'J';
-
-const vector<char> cardLabels = {
-    '2', '3', '4', '5', '6', '7', '8', '9', 'T', 'J', 'Q', 'K', 'A',
-};
-
-const map<char, size_t> cardRanking = {
-    {'2', 0},
-    {'3', 1},
-    {'4', 2},
-    {'5', 3},
-    {'6', 4},
-    {'7', 5},
-    {'8', 6},
-    {'9', 7},
-    {'T', 8},
-    {'J', 9},
-    {'Q', 10},
-    {'K', 11},
-    {'A', 12},
-};
-
-const map<char, size_t> cardRankingJoker = {
-    {'J', 0},
-    {'2', 1},
-    {'3', 2},
-    {'4', 3},
-    {'5', 4},
-    {'6', 5},
-    {'7', 6},
-    {'8', 7},
-    {'9', 8},
-    {'T', 9},
-    {'Q', 10},
-    {'K', 11},
-    {'A', 12},
-};
+const string kCardOrder = "23456789TJQKA";
+const string kCardOrderJoker = "J23456789TQKA";  // the joker is the weakest card
 
 enum HandType {
     None = 0,
@@ -73,254 +34,131 @@ struct Hand {
     size_t bid;
 };
 
-struct HandComparator {
-    bool operator() (const Hand &lhs, const Hand &rhs) const {
-        for (size_t i = 0; i < lhs.cards.size(); i++) {
-            const auto lCard = lhs.cards[i];
-            const auto rCard = rhs.cards[i];
-
-            const auto lRanking = cardRanking.at(lCard);
-            const auto rRanking = cardRanking.at(rCard);
-            if (lRanking == rRanking) {
-                continue;
-            }
-
-            return lRanking < rRanking;
-        }
-
-        return true;
-    }
+// A hand's type and cards packed so that comparing keys compares hands: the type in bits 20-23,
+// then the strength of each card, first card first, in one nibble each.
+struct RankedHand {
+    uint32_t key;
+    size_t bid;
 };
 
-struct HandComparatorJoker {
-    bool operator() (const Hand &lhs, const Hand &rhs) const {
-        for (size_t i = 0; i < lhs.cards.size(); i++) {
-            const auto lCard = lhs.cards[i];
-            const auto rCard = rhs.cards[i];
+typedef array<uint8_t, 256> card_table_t;
 
-            const auto lRanking = cardRankingJoker.at(lCard);
-            const auto rRanking = cardRankingJoker.at(rCard);
-            if (lRanking == rRanking) {
-                continue;
-            }
+// strength of every card label, with 0xFF for characters that are not cards
+const card_table_t _buildCardTable(const string &cardOrder) {
+    card_table_t table;
+    table.fill(0xFF);
+    for (size_t i = 0; i < cardOrder.size(); i++) {
+        table[static_cast<uint8_t>(cardOrder[i])] = i;
+    }
+    return table;
+}
 
-            return lRanking < rRanking;
-        }
+const card_table_t kCardValues = _buildCardTable(kCardOrder);
+const card_table_t kCardValuesJoker = _buildCardTable(kCardOrderJoker);
 
-        return true;
-    }
+// The sum of the squared card counts tells the types apart: 5 (high card), 7 (one pair), 9 (two
+// pairs), 11 (three of a kind), 13 (full house), 17 (four of a kind) and 25 (five of a kind).
+const array<uint8_t, kHandSize * kHandSize + 1> kTypeBySumOfSquares = {
+    None, None, None, None, None, HighCard, None, OnePair, None, TwoPair, None, ThreeOfKind, None,
+    FullHouse, None, None, None, FourOfKind, None, None, None, None, None, None, None, FiveOfKind,
 };
 
 vector<Hand> _parseInput(istream& inputFile) {
     vector<Hand> hands;
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+    string line;
+    while (getline(inputFile, line)) {
+        if (line.empty()) {
+            continue;
+        }
 
-        smatch handMatch;
-        if (!regex_match(line, handMatch, HAND_RX)) {
-            cout << "HAND_RX failed to match line: { " << line << " }" << endl;
+        const size_t spacePos = line.find(' ');
+        const bool isValid = spacePos == kHandSize &&
+                             all_of(line.begin(), line.begin() + spacePos, [](const char c) { return kCardValues[static_cast<uint8_t>(c)] != 0xFF; }) &&
+                             spacePos + 1 < line.size() &&
+                             all_of(line.begin() + spacePos + 1, line.end(), [](const char c) { return isdigit(c); });
+        if (!isValid) {
+            cout << "Failed to parse hand from line: { " << line << " }" << endl;
             exit(1);
         }
 
         hands.push_back({
-            .cards = handMatch[1].str(),
-            .bid = static_cast<size_t>(stoul(handMatch[2].str())),
+            .cards = line.substr(0, spacePos),
+            .bid = static_cast<size_t>(stoul(line.substr(spacePos + 1))),
         });
     }
 
     return hands;
 }
 
-HandType _computeHandTypeLegacy(const Hand &hand, optional<char> jokerReplacement = nullopt) {
-    array<size_t, kDeckSize> cardCount { 0 };
-
-    for (const auto c : hand.cards) {
-        char card = c;
-        if (jokerReplacement && c == kJokerCard) {
-            card = *jokerReplacement;
-        }
-        cardCount[cardRanking.at(card)] += 1;
-    }
-
-    size_t threeCount = 0;
-    size_t twoCount = 0;
-    for (const auto count : cardCount) {
-        if (count == 5) {
-            return FiveOfKind;
-        } else if (count == 4) {
-            return FourOfKind;
-        } else if (count == 3) {
-            threeCount += 1;
-        } else if (count == 2) {
-            twoCount += 1;
-        }
-    }
+// Jokers always join the most common other card, which is the best type they can make.
+uint32_t _encodeHand(const Hand &hand, const bool withJokers) {
+    const auto &cardValues = withJokers ? kCardValuesJoker : kCardValues;
 
-    if (threeCount == 1 && twoCount == 1) {
-        return FullHouse;
-    } else if (threeCount == 1) {
-        return ThreeOfKind;
+    array<uint8_t, 16> cardCount = {0};
+    uint32_t key = 0;
+    for (size_t i = 0; i < kHandSize; i++) {
+        const uint8_t value = cardValues[static_cast<uint8_t>(hand.cards[i])];
+        cardCount[value] += 1;
+        key = (key << 4) | value;
     }
 
-    if (twoCount == 2) {
-        return TwoPair;
-    }
+    // the joker has strength 0 in joker mode, in normal mode 'J' is an ordinary card
+    const uint32_t jokerCount = withJokers ? cardCount[0] : 0;
+    cardCount[0] -= jokerCount;
 
-    if (twoCount == 1) {
-        return OnePair;
+    uint32_t sumOfSquares = 0;
+    uint32_t maxCount = 0;
+    for (const uint32_t count : cardCount) {
+        sumOfSquares += count * count;
+        maxCount = max(maxCount, count);
     }
+    sumOfSquares += (maxCount + jokerCount) * (maxCount + jokerCount) - maxCount * maxCount;
 
-    return HighCard;
+    return (static_cast<uint32_t>(kTypeBySumOfSquares[sumOfSquares]) << (4 * kHandSize)) | key;
 }
 
-HandType _computeHandType(const Hand &hand, bool replaceJoker = false) {
-    array<size_t, kDeckSize> cardCount { 0 };
-
-    for (const auto c : hand.cards) {
-        cardCount[cardRanking.at(c)] += 1;
-    }
-
-    const auto jokerCount = cardCount[cardRanking.at(kJokerCard)];
-    if (replaceJoker && jokerCount > 0) {
-        size_t maxCount = 0;
-        for (size_t i = 0; i < cardCount.size(); i++) {
-            if (i == cardRanking.at(kJokerCard)) {
-                continue;
-            }
-
-            maxCount = max(maxCount, cardCount[i]);
+// LSD radix sort on the 24 bits of the keys, one byte per pass.
+void _radixSort(vector<RankedHand> &hands) {
+    vector<RankedHand> buffer(hands.size());
+    for (uint32_t shift = 0; shift < 4 * (kHandSize + 1); shift += 8) {
+        array<size_t, 257> offsets = {0};
+        for (const auto &hand : hands) {
+            offsets[((hand.key >> shift) & 0xFF) + 1] += 1;
         }
-
-        // it doesn't matter to which we assign here, custom comparator will deal with it later
-        for (size_t i = 0; i < cardCount.size() && maxCount > 0; i++) {
-            if (i == cardRanking.at(kJokerCard)) {
-                continue;
-            }
-
-            if (cardCount[i] == maxCount) {
-                cardCount[i] += jokerCount;
-                cardCount[cardRanking.at(kJokerCard)] = 0;
-                break;
-            }
+        for (size_t i = 1; i < offsets.size(); i++) {
+            offsets[i] += offsets[i - 1];
         }
-    }
-
-    size_t threeCount = 0;
-    size_t twoCount = 0;
-    for (const auto count : cardCount) {
-        if (count == 5) {
-            return FiveOfKind;
-        } else if (count == 4) {
-            return FourOfKind;
-        } else if (count == 3) {
-            threeCount += 1;
-        } else if (count == 2) {
-            twoCount += 1;
+        for (const auto &hand : hands) {
+            buffer[offsets[(hand.key >> shift) & 0xFF]++] = hand;
         }
+        swap(hands, buffer);
     }
-
-    if (threeCount == 1 && twoCount == 1) {
-        return FullHouse;
-    } else if (threeCount == 1) {
-        return ThreeOfKind;
-    }
-
-    if (twoCount == 2) {
-        return TwoPair;
-    }
-
-    if (twoCount == 1) {
-        return OnePair;
-    }
-
-    return HighCard;
 }
 
-void part1(const vector<Hand> &hands) {
-    map<HandType, set<Hand, HandComparator>> typeToHands;
-
+int64_t _computeTotalWinnings(const vector<Hand> &hands, const bool withJokers) {
+    vector<RankedHand> rankedHands;
+    rankedHands.reserve(hands.size());
     for (const auto &hand : hands) {
-        const auto type = _computeHandType(hand);
-        typeToHands[type].insert(hand);
+        rankedHands.push_back({_encodeHand(hand, withJokers), hand.bid});
     }
 
+    _radixSort(rankedHands);
+
     int64_t totalWinnings = 0;
-    size_t rank = 1;
-    for (const auto &p : typeToHands) {
-        for (const auto &hand : p.second) {
-            totalWinnings += rank * hand.bid;
-            rank += 1;
-        }
+    for (size_t i = 0; i < rankedHands.size(); i++) {
+        totalWinnings += (i + 1) * rankedHands[i].bid;
     }
 
-    cout << totalWinnings << endl;
+    return totalWinnings;
 }
 
-void part2Legacy(const vector<Hand> &hands) {
-    map<HandType, set<Hand, HandComparatorJoker>> typeToHands;
-
-    for (const auto &hand : hands) {
-        HandType strongestType = _computeHandTypeLegacy(hand);
-        if (hand.cards.contains(kJokerCard) && strongestType < FiveOfKind) {
-            for (const auto card : cardLabels) {
-                if (card == kJokerCard) {
-                    continue;
-                }
-
-                Hand shapeshiftHand = hand;
-                replace(shapeshiftHand.cards.begin(), shapeshiftHand.cards.end(), kJokerCard, card);
-
-                const auto type = _computeHandTypeLegacy(shapeshiftHand);
-                if (type > strongestType) {
-                    strongestType = type;
-                    if (strongestType == FiveOfKind) {
-                        break;
-                    }
-                }
-            }
-        }
-
-        typeToHands[strongestType].insert(hand);
-    }
-
-    int64_t totalWinnings = 0;
-    size_t rank = 1;
-    for (const auto &p : typeToHands) {
-        // cout << "Type: " << p.first << endl;
-        for (const auto &hand : p.second) {
-            // cout << hand.cards << " -> " << rank << endl;
-            totalWinnings += rank * hand.bid;
-            rank += 1;
-        }
-        // cout << endl;
-    }
-
-    cout << totalWinnings << endl;
+void part1(const vector<Hand> &hands) {
+    cout << _computeTotalWinnings(hands, false) << endl;
 }
 
 void part2(const vector<Hand> &hands) {
-    map<HandType, set<Hand, HandComparatorJoker>> typeToHands;
-
-    for (const auto &hand : hands) {
-        const auto type = _computeHandType(hand, true);
-        typeToHands[type].insert(hand);
-    }
-
-    int64_t totalWinnings = 0;
-    size_t rank = 1;
-    for (const auto &p : typeToHands) {
-        // cout << "Type: " << p.first << endl;
-        for (const auto &hand : p.second) {
-            // cout << hand.cards << " -> " << rank << endl;
-            totalWinnings += rank * hand.bid;
-            rank += 1;
-        }
-        // cout << endl;
-    }
-
-    cout << totalWinnings << endl;
+    cout << _computeTotalWinnings(hands, true) << endl;
 }
 
 int main(int argc, char **argv) {
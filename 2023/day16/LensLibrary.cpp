@@ -8,11 +8,15 @@
 #include <cstdint>
 #include <vector>
 #include <utility>
-#include <queue>
-#include <set>
-#include <tuple>
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <climits>
+
+#include "../../util/Parallel.h"
 
 using namespace std;
+using namespace aoc::util::parallel;
 
 typedef pair<size_t, size_t> coord_t;
 
@@ -23,24 +27,6 @@ enum Direction {
     West,
 };
 
-struct PositionData {
-    coord_t coord;
-    Direction dir;
-
-    bool operator==(const PositionData &other) const {
-        return tie(coord, dir) == tie(other.coord, other.dir);
-    }
-
-    bool operator<(const PositionData &other) const {
-        return tie(coord, dir) < tie(other.coord, other.dir);
-    }
-};
-
-struct BFSOutput {
-    set<coord_t> visitedCoords;
-    set<coord_t> visitedEdgeExitCoords;
-};
-
 struct Input {
     vector<string> grid;
     size_t nRows;
@@ -71,202 +57,333 @@ void _printInput(const Input &input) {
     cout << endl;
 }
 
-Direction _getDirectionFromCoordDelta(const coord_t &coordDelta) {
-    if (coordDelta == coord_t{-1, 0}) {
-        return North;
-    }
+const int64_t kRowDeltas[] = {-1, 0, 1, 0};
+const int64_t kColDeltas[] = {0, 1, 0, -1};
 
-    if (coordDelta == coord_t{1, 0}) {
-        return South;
-    }
+const size_t kNoSplitter = SIZE_MAX;
 
-    if (coordDelta == coord_t{0, -1}) {
-        return West;
-    }
+struct BeamEntry {
+    coord_t coord;
+    Direction dir;
+};
 
-    if (coordDelta == coord_t{0, 1}) {
-        return East;
-    }
+// A beam traced from a starting state until it either leaves the grid, loops back onto itself, or
+// hits a splitter from its flat side (targetSplitter).
+struct BeamTrace {
+    vector<uint32_t> cells;  // energized cells, in beam order (a cell can show up more than once)
+    size_t targetSplitter = kNoSplitter;
+};
 
-    cout << "Unknown direction for coord delta: (" << coordDelta.first << ", " <<coordDelta.second << ")" << endl;
-    exit(1);
+// Every splitter hit from its flat side behaves the same no matter which side the beam came from, so
+// splitters are the nodes of a graph whose edges are the two beam segments leaving them. The graph is
+// condensed into strongly connected components, and every component reachable from an entry gets the
+// bitset of all the cells energized once any of its splitters is hit.
+struct SplitterGraph {
+    vector<size_t> cellToSplitter;
+    vector<uint32_t> splitterCells;
+    vector<array<BeamTrace, 2>> outgoing;
+
+    vector<size_t> splitterToScc;
+    vector<vector<size_t>> sccSplitters;      // in reverse topological order: successors come first
+    vector<vector<uint64_t>> sccEnergized;    // empty for components no entry reaches
+    vector<size_t> sccEnergizedCount;
+};
+
+bool _splits(const char tile, const Direction dir) {
+    return (tile == '|' && (dir == East || dir == West)) || (tile == '-' && (dir == North || dir == South));
 }
 
-vector<coord_t> _getCoordDeltas(const Direction &dir, const char currentTile) {
-    if (currentTile == '.') {
+Direction _reflect(const char tile, const Direction dir) {
+    if (tile == '\\') {
         switch (dir) {
-            case North: return {{-1, 0}};
-            case East: return {{0, 1}};
-            case South: return {{1, 0}};
-            case West: return {{0, -1}};
+            case North: return West;
+            case East: return South;
+            case South: return East;
+            case West: return North;
         };
     }
 
-    if (currentTile == '\\') {
+    if (tile == '/') {
         switch (dir) {
-            case North: return {{0, -1}};
-            case East: return {{1, 0}};
-            case South: return {{0, 1}};
-            case West: return {{-1, 0}};
+            case North: return East;
+            case East: return North;
+            case South: return West;
+            case West: return South;
         };
     }
 
-    if (currentTile == '/') {
-        switch (dir) {
-            case North: return {{0, 1}};
-            case East: return {{-1, 0}};
-            case South: return {{0, -1}};
-            case West: return {{1, 0}};
-        };
-    }
+    return dir;
+}
 
-    if (currentTile == '|') {
-        switch (dir) {
-            case North: return {{-1, 0}};
-            case East: return {{-1, 0}, {1, 0}};
-            case South: return {{1, 0}};
-            case West: return {{-1, 0}, {1, 0}};
-        };
-    }
+// Traces the beam that is on (row, col) moving towards dir, starting with that cell's own tile.
+BeamTrace _traceBeam(int64_t row, int64_t col, Direction dir, const Input &input, const SplitterGraph &graph) {
+    BeamTrace trace;
 
-    if (currentTile == '-') {
-        switch (dir) {
-            case North: return {{0, -1}, {0, 1}};
-            case East: return {{0, 1}};
-            case South: return {{0, -1}, {0, 1}};
-            case West: return {{0, -1}};
-        };
+    const auto startRow = row;
+    const auto startCol = col;
+    const auto startDir = dir;
+
+    while (row >= 0 && row < (int64_t)input.nRows && col >= 0 && col < (int64_t)input.nCols) {
+        const auto tile = input.grid[row][col];
+        const uint32_t cell = row * input.nCols + col;
+
+        if (_splits(tile, dir)) {
+            trace.targetSplitter = graph.cellToSplitter[cell];
+            break;
+        }
+
+        trace.cells.push_back(cell);
+
+        dir = _reflect(tile, dir);
+        row += kRowDeltas[dir];
+        col += kColDeltas[dir];
+
+        // beams are reversible, so a beam can only loop back onto its own starting state
+        if (row == startRow && col == startCol && dir == startDir) {
+            break;
+        }
     }
 
-    cout << "Unknown coord delta for tile: " << currentTile << " and direction: " << dir << endl;
-    exit(1);
+    return trace;
 }
 
-vector<PositionData> _getNextPositions(const PositionData &currentPosition, const Input &input) {
-    const auto currentTile = input.grid[currentPosition.coord.first][currentPosition.coord.second];
+void _findSccs(SplitterGraph &graph) {
+    const size_t numSplitters = graph.splitterCells.size();
+    const size_t kUnvisited = SIZE_MAX;
 
-    vector<PositionData> nextPositions;
-    const auto coordDeltas = _getCoordDeltas(currentPosition.dir, currentTile);
-    for (const auto &delta : coordDeltas) {
-        nextPositions.emplace_back(PositionData {
-            .coord = { currentPosition.coord.first + delta.first, currentPosition.coord.second + delta.second },
-            .dir = _getDirectionFromCoordDelta(delta),
-        });
-    }
+    // iterative Tarjan, which emits every component after all the components reachable from it
+    vector<size_t> index(numSplitters, kUnvisited);
+    vector<size_t> lowLink(numSplitters, 0);
+    vector<bool> onStack(numSplitters, false);
+    vector<size_t> sccStack;
+    vector<pair<size_t, size_t>> callStack;  // (splitter, next outgoing segment to look at)
+    size_t nextIndex = 0;
+
+    graph.splitterToScc.assign(numSplitters, kNoSplitter);
+
+    for (size_t root = 0; root < numSplitters; root++) {
+        if (index[root] != kUnvisited) {
+            continue;
+        }
+
+        callStack.push_back({root, 0});
+        while (!callStack.empty()) {
+            const auto node = callStack.back().first;
+            auto &segmentIdx = callStack.back().second;
+
+            if (segmentIdx == 0 && index[node] == kUnvisited) {
+                index[node] = lowLink[node] = nextIndex++;
+                sccStack.push_back(node);
+                onStack[node] = true;
+            }
+
+            if (segmentIdx < 2) {
+                const auto next = graph.outgoing[node][segmentIdx++].targetSplitter;
+                if (next == kNoSplitter) {
+                    continue;
+                }
+
+                if (index[next] == kUnvisited) {
+                    callStack.push_back({next, 0});
+                } else if (onStack[next]) {
+                    lowLink[node] = min(lowLink[node], index[next]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                const auto parent = callStack.back().first;
+                lowLink[parent] = min(lowLink[parent], lowLink[node]);
+            }
 
-    return nextPositions;
+            if (lowLink[node] == index[node]) {
+                graph.sccSplitters.emplace_back();
+                size_t member;
+                do {
+                    member = sccStack.back();
+                    sccStack.pop_back();
+                    onStack[member] = false;
+                    graph.splitterToScc[member] = graph.sccSplitters.size() - 1;
+                    graph.sccSplitters.back().push_back(member);
+                } while (member != node);
+            }
+        }
+    }
 }
 
-bool _isValidCoord(const coord_t &coord, const Input &input) {
-    if (coord.first < 0 || coord.first >= input.nRows) {
-        return false;
+const SplitterGraph _buildSplitterGraph(const Input &input) {
+    SplitterGraph graph;
+
+    graph.cellToSplitter.assign(input.nRows * input.nCols, kNoSplitter);
+    for (size_t row = 0; row < input.nRows; row++) {
+        for (size_t col = 0; col < input.nCols; col++) {
+            const auto tile = input.grid[row][col];
+            if (tile == '|' || tile == '-') {
+                graph.cellToSplitter[row * input.nCols + col] = graph.splitterCells.size();
+                graph.splitterCells.push_back(row * input.nCols + col);
+            }
+        }
     }
 
-    if (coord.second < 0 || coord.second >= input.nCols) {
-        return false;
+    graph.outgoing.resize(graph.splitterCells.size());
+    for (size_t splitter = 0; splitter < graph.splitterCells.size(); splitter++) {
+        const int64_t row = graph.splitterCells[splitter] / input.nCols;
+        const int64_t col = graph.splitterCells[splitter] % input.nCols;
+
+        const auto outDirs = input.grid[row][col] == '|' ? array<Direction, 2>{North, South} : array<Direction, 2>{East, West};
+        for (size_t i = 0; i < outDirs.size(); i++) {
+            const auto dir = outDirs[i];
+            graph.outgoing[splitter][i] = _traceBeam(row + kRowDeltas[dir], col + kColDeltas[dir], dir, input, graph);
+        }
     }
 
-    return true;
+    _findSccs(graph);
+
+    return graph;
 }
 
-BFSOutput _bfs(const PositionData &startPosition, const Input &input) {
-    BFSOutput output;
+// Fills in the energized bitsets of all the components reachable from the given entry traces.
+void _computeEnergizedSccs(const vector<BeamTrace> &entryTraces, const Input &input, SplitterGraph &graph) {
+    const size_t numSccs = graph.sccSplitters.size();
 
-    queue<PositionData> positionsToVisit;
+    vector<bool> isReachable(numSccs, false);
+    vector<size_t> toVisit;
+    for (const auto &trace : entryTraces) {
+        if (trace.targetSplitter != kNoSplitter) {
+            toVisit.push_back(graph.splitterToScc[trace.targetSplitter]);
+        }
+    }
+    while (!toVisit.empty()) {
+        const auto scc = toVisit.back();
+        toVisit.pop_back();
+        if (isReachable[scc]) {
+            continue;
+        }
 
-    set<PositionData> visitedPositions;
+        isReachable[scc] = true;
+        for (const auto splitter : graph.sccSplitters[scc]) {
+            for (const auto &segment : graph.outgoing[splitter]) {
+                if (segment.targetSplitter != kNoSplitter) {
+                    toVisit.push_back(graph.splitterToScc[segment.targetSplitter]);
+                }
+            }
+        }
+    }
 
-    positionsToVisit.push(startPosition);
+    // successors come first, so their bitsets are always complete by the time we need them
+    const size_t numWords = (input.nRows * input.nCols + 63) / 64;
+    graph.sccEnergized.assign(numSccs, {});
+    graph.sccEnergizedCount.assign(numSccs, 0);
+    for (size_t scc = 0; scc < numSccs; scc++) {
+        if (!isReachable[scc]) {
+            continue;
+        }
 
-    while (!positionsToVisit.empty()) {
-        const auto currentPosition = positionsToVisit.front();
-        positionsToVisit.pop();
+        auto &energized = graph.sccEnergized[scc];
+        energized.assign(numWords, 0);
+        for (const auto splitter : graph.sccSplitters[scc]) {
+            const auto splitterCell = graph.splitterCells[splitter];
+            energized[splitterCell / 64] |= 1ull << (splitterCell % 64);
+
+            for (const auto &segment : graph.outgoing[splitter]) {
+                for (const auto cell : segment.cells) {
+                    energized[cell / 64] |= 1ull << (cell % 64);
+                }
+
+                if (segment.targetSplitter == kNoSplitter) {
+                    continue;
+                }
+
+                const auto nextScc = graph.splitterToScc[segment.targetSplitter];
+                if (nextScc != scc) {
+                    const auto &nextEnergized = graph.sccEnergized[nextScc];
+                    for (size_t w = 0; w < numWords; w++) {
+                        energized[w] |= nextEnergized[w];
+                    }
+                }
+            }
+        }
 
-        if (visitedPositions.contains(currentPosition)) {
-            continue;
+        for (const auto word : energized) {
+            graph.sccEnergizedCount[scc] += popcount(word);
         }
+    }
+}
 
-        visitedPositions.insert(currentPosition);
-        output.visitedCoords.insert(currentPosition.coord);
+// Number of energized tiles for every entry: the cells of the entry's own trace up to the first
+// splitter, unioned with the precomputed bitset of that splitter's component.
+const vector<size_t> _countEnergizedTiles(const vector<BeamEntry> &entries, const Input &input) {
+    auto graph = _buildSplitterGraph(input);
 
-        const auto potentialNextPositions = _getNextPositions(currentPosition, input);
-        for (const auto &potentialNextPosition : potentialNextPositions) {
-            if (!_isValidCoord(potentialNextPosition.coord, input)) {
-                output.visitedEdgeExitCoords.insert(currentPosition.coord);
-                continue;
+    vector<BeamTrace> entryTraces;
+    for (const auto &entry : entries) {
+        entryTraces.push_back(_traceBeam(entry.coord.first, entry.coord.second, entry.dir, input, graph));
+    }
+
+    _computeEnergizedSccs(entryTraces, input, graph);
+
+    vector<size_t> energizedTiles(entries.size(), 0);
+
+    parallelForChunks(entries.size(), [&](const size_t, const size_t startIdx, const size_t endIdx) {
+        // cells of the current entry's trace are stamped with its index, to count them only once
+        vector<size_t> cellStamps(input.nRows * input.nCols, SIZE_MAX);
+
+        for (size_t entryIdx = startIdx; entryIdx < endIdx; entryIdx++) {
+            const auto &trace = entryTraces[entryIdx];
+
+            const uint64_t *sccEnergized = nullptr;
+            size_t count = 0;
+            if (trace.targetSplitter != kNoSplitter) {
+                const auto scc = graph.splitterToScc[trace.targetSplitter];
+                sccEnergized = graph.sccEnergized[scc].data();
+                count = graph.sccEnergizedCount[scc];
             }
 
-            positionsToVisit.push(potentialNextPosition);
+            for (const auto cell : trace.cells) {
+                if (cellStamps[cell] == entryIdx) {
+                    continue;
+                }
+                cellStamps[cell] = entryIdx;
+
+                if (sccEnergized == nullptr || !(sccEnergized[cell / 64] & (1ull << (cell % 64)))) {
+                    count += 1;
+                }
+            }
+
+            energizedTiles[entryIdx] = count;
         }
-    }
+    });
 
-    return output;
+    return energizedTiles;
 }
 
 void part1(const Input &input) {
-    const PositionData startPosition = {
+    const BeamEntry startPosition = {
         .coord = {0, 0},
         .dir = East,
     };
 
-    const auto energizeOutput = _bfs(startPosition, input);
-    const auto totalEnergizedTiles = energizeOutput.visitedCoords.size();
+    const auto totalEnergizedTiles = _countEnergizedTiles({startPosition}, input).front();
 
     cout << totalEnergizedTiles << endl;
 }
 
 void part2(const Input &input) {
-    set<coord_t> visitedEdgeExitCoords;
-
-    size_t maxEnergizedTiles = 0;
+    vector<BeamEntry> entries;
     for (size_t i = 0; i < input.nRows; i++) {
-        const PositionData startPositionToEast = {
-            .coord = {i, 0},
-            .dir = East,
-        };
-
-        if (!visitedEdgeExitCoords.contains(startPositionToEast.coord)) {
-            auto energizeOutput = _bfs(startPositionToEast, input);
-            maxEnergizedTiles = max(maxEnergizedTiles, energizeOutput.visitedCoords.size());
-            visitedEdgeExitCoords.merge(energizeOutput.visitedEdgeExitCoords);
-        }
-
-        const PositionData startPositionToWest = {
-            .coord = {i, input.nCols - 1},
-            .dir = West,
-        };
-
-        if (!visitedEdgeExitCoords.contains(startPositionToWest.coord)) {
-            auto energizeOutput = _bfs(startPositionToWest, input);
-            maxEnergizedTiles = max(maxEnergizedTiles, energizeOutput.visitedCoords.size());
-            visitedEdgeExitCoords.merge(energizeOutput.visitedEdgeExitCoords);
-        }
+        entries.push_back({.coord = {i, 0}, .dir = East});
+        entries.push_back({.coord = {i, input.nCols - 1}, .dir = West});
     }
 
     for (size_t i = 0; i < input.nCols; i++) {
-        const PositionData startPositionToSouth = {
-            .coord = {0, i},
-            .dir = South,
-        };
-
-        if (!visitedEdgeExitCoords.contains(startPositionToSouth.coord)) {
-            auto energizeOutput = _bfs(startPositionToSouth, input);
-            maxEnergizedTiles = max(maxEnergizedTiles, energizeOutput.visitedCoords.size());
-            visitedEdgeExitCoords.merge(energizeOutput.visitedEdgeExitCoords);
-        }
-
-        const PositionData startPositionToNorth = {
-            .coord = {input.nRows - 1, i},
-            .dir = North,
-        };
-
-        if (!visitedEdgeExitCoords.contains(startPositionToNorth.coord)) {
-            auto energizeOutput = _bfs(startPositionToNorth, input);
-            maxEnergizedTiles = max(maxEnergizedTiles, energizeOutput.visitedCoords.size());
-            visitedEdgeExitCoords.merge(energizeOutput.visitedEdgeExitCoords);
-        }
+        entries.push_back({.coord = {0, i}, .dir = South});
+        entries.push_back({.coord = {input.nRows - 1, i}, .dir = North});
     }
 
+    const auto energizedTiles = _countEnergizedTiles(entries, input);
+    const auto maxEnergizedTiles = *max_element(energizedTiles.begin(), energizedTiles.end());
+
     cout << maxEnergizedTiles << endl;
 }
 
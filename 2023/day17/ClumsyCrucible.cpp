@@ -1,6 +1,4 @@
 #include "../../util/StringUtil.h"
-#include "../../util/MathUtil.h"
-#include "../../util/Types.h"
 
 #include <iostream>
 #include <fstream>
@@ -9,250 +7,161 @@
 #include <cstdint>
 #include <vector>
 #include <utility>
-#include <set>
-#include <queue>
 
 using namespace std;
-using namespace aoc::util::types;
 
-using VULL = vector<size_t>;
-using VVULL = vector<VULL>;
-using VVVULL = vector<VVULL>;
-using VVVVULL = vector<VVVULL>;
+constexpr uint32_t kMaxBlockLoss = 9;
+constexpr uint32_t kUnreachable = UINT32_MAX;
 
+// heat loss of every city block, row-major
 struct Input {
-    VVULL cityMap;
+    vector<uint8_t> cityMap;
     size_t nRows;
     size_t nCols;
-    coord_t destination;
-    size_t minStraightBlocks;
-    size_t maxStraightBlocks;
 };
 
-enum Orientation {
-    North = 0,
-    East,
-    South,
-    West,
-
-    OrientationCount,
+struct CrucibleConstraints {
+    size_t minStraightBlocks;
+    size_t maxStraightBlocks;
 };
 
-struct LeastLossState {
-    coord_t coord;
-    Orientation orientation;
-    size_t straightBlocks;
-    size_t pathLoss;
-};
+// Axis of the last straight run. After every run the crucible has to turn, so it leaves a block
+// along the other axis, in either direction, which makes the remaining run length and the exact
+// orientation irrelevant to the search.
+enum Axis {
+    Vertical = 0,
+    Horizontal,
 
-// NOTE: https://en.cppreference.com/w/cpp/container/priority_queue
-// Note that the Compare parameter is defined such that it returns true if its first
-// argument comes before its second argument in a weak ordering. But because the priority
-// queue outputs largest elements first, the elements that "come before" are actually
-// output last. That is, the front of the queue contains the "last" element according to
-// the weak ordering imposed by Compare.
-struct LeastLossStateCompare
-{
-    bool operator()(const LeastLossState& s1, const LeastLossState& s2) const
-    {
-        return s1.pathLoss > s2.pathLoss;
-    }
+    AxisCount,
 };
 
-typedef priority_queue<LeastLossState, vector<LeastLossState>, LeastLossStateCompare> loss_state_priority_queue_t;
-
 const Input _parseInput(istream& inputFile) {
-    Input input;
+    Input input = {};
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+    string line;
+    while (getline(inputFile, line)) {
+        if (line.empty()) {
+            continue;
+        }
 
-        vector<size_t> cityMapLine;
-        for (const auto &ch : line) {
-            cityMapLine.push_back(ch - '0');
+        if (input.nCols == 0) {
+            input.nCols = line.size();
+        } else if (line.size() != input.nCols) {
+            cout << "Row " << input.nRows << " has " << line.size() << " blocks, expected " << input.nCols << endl;
+            exit(1);
         }
 
-        input.cityMap.push_back(cityMapLine);
+        for (const auto &ch : line) {
+            input.cityMap.push_back(ch - '0');
+        }
+        input.nRows += 1;
     }
 
-    input.nRows = input.cityMap.size();
-    input.nCols = input.cityMap[0].size();
-
     return input;
 }
 
 void _printInput(const Input &input) {
     cout << "City map: (" << input.nRows << ", " << input.nCols << ")" << endl;
-    for (const auto &line : input.cityMap) {
-        for (const auto &v : line) {
-            cout << v << " ";
+    for (size_t row = 0; row < input.nRows; row++) {
+        for (size_t col = 0; col < input.nCols; col++) {
+            cout << static_cast<int>(input.cityMap[row * input.nCols + col]) << " ";
         }
         cout << endl;
     }
     cout << endl;
 }
 
-void _printState(const LeastLossState &state) {
-    cout << "State: [ ("<< state.coord.first << ", " << state.coord.second << ") orientation:" << state.orientation << " ";
-    cout << "pathloss:" << state.pathLoss << " ";
-    cout << "straightBlocks:" << state.straightBlocks << endl;
-}
-
-bool _isValidNextCoord(const coord_t &nextCoord, const Input &input) {
-    if (nextCoord.first < 0 || nextCoord.first >= input.nRows) {
-        return false;
-    }
-
-    if (nextCoord.second < 0 || nextCoord.second >= input.nCols) {
-        return false;
-    }
-
-    return true;
-}
-
-bool _isDestinationState(const LeastLossState &currentState, const Input &input) {
-    if (currentState.coord == input.destination) {
-        return true;
-    }
-
-    return false;
-}
-
-coord_t _getNextCoordForOrientation(const coord_t &currentCoord, const Orientation &orientation) {
-    if (orientation < 0 || orientation >= OrientationCount) {
-        cout << "Unknown orientation " << orientation << " for coord (" << currentCoord.first << ", " << currentCoord.second << ")" << endl;
-        exit(1);
-    }
-
-    switch (orientation) {
-        case North: return {currentCoord.first - 1, currentCoord.second};
-        case East: return {currentCoord.first, currentCoord.second + 1};
-        case South: return {currentCoord.first + 1, currentCoord.second};
-        case West: return {currentCoord.first, currentCoord.second - 1};
-        default: return {0, 0};
+// Dijkstra over (block, axis) states: every edge turns and then goes straight for a whole run of
+// minStraightBlocks..maxStraightBlocks blocks, its loss being the running sum of the blocks entered.
+// Edge losses are small integers, so the priority queue is a ring of buckets indexed by loss
+// (Dial's algorithm): a run costs at most kMaxBlockLoss * maxStraightBlocks, so a ring one bucket
+// longer than that never mixes up two different losses.
+uint32_t _leastHeatLoss(const Input &input, const CrucibleConstraints &constraints) {
+    const size_t nBlocks = input.nRows * input.nCols;
+    const size_t destination = nBlocks - 1;
+    if (nBlocks <= 1) {
+        return 0;
     }
-}
 
-LeastLossState _createNextState(const coord_t &nextCoord, const Orientation &nextOrientation, const LeastLossState &currentState, const Input &input) {
-    LeastLossState nextState = {
-        .coord = nextCoord,
-        .orientation = nextOrientation,
-    };
+    // losses[block * AxisCount + axis]
+    vector<uint32_t> losses(nBlocks * AxisCount, kUnreachable);
+    vector<vector<uint32_t>> buckets(kMaxBlockLoss * constraints.maxStraightBlocks + 1);
 
-    if (nextState.orientation == currentState.orientation) {
-        nextState.straightBlocks = currentState.straightBlocks + 1;
-    } else {
-        nextState.straightBlocks = 1;
+    // the start has no previous run, so it may leave along either axis
+    for (size_t axis = 0; axis < AxisCount; axis++) {
+        losses[axis] = 0;
+        buckets[0].push_back(axis);
     }
 
-    return nextState;
-}
-
-vector<LeastLossState> _getNeighbors(const LeastLossState &currentState, const Input &input) {
-    vector<LeastLossState> neighbors;
-
-    Orientation orientation = currentState.orientation;
-
-    // continue straight if possible
-    if (currentState.straightBlocks < input.maxStraightBlocks) {
-        const auto nextCoord = _getNextCoordForOrientation(currentState.coord, orientation);
+    size_t numQueued = AxisCount;
+    for (uint32_t loss = 0; numQueued > 0; loss++) {
+        auto &bucket = buckets[loss % buckets.size()];
 
-        if (_isValidNextCoord(nextCoord, input)) {
-            neighbors.emplace_back(_createNextState(nextCoord, orientation, currentState, input));
-        }
-    }
+        // the bucket may grow while it is scanned, by runs with no loss at all
+        for (size_t i = 0; i < bucket.size(); i++) {
+            const uint32_t state = bucket[i];
+            numQueued -= 1;
+            if (losses[state] != loss) {
+                continue;
+            }
 
-    // get left/right orientations if possible
-    if (currentState.straightBlocks >= input.minStraightBlocks) {
-        const auto left90Orientation = static_cast<Orientation>(aoc::util::math::positiveModulo(static_cast<int>(orientation) - 1, OrientationCount));
-        const auto right90Orientation = static_cast<Orientation>(aoc::util::math::positiveModulo(static_cast<int>(orientation) + 1, OrientationCount));
-        for (const auto &nextOrientation : {left90Orientation, right90Orientation}) {
-            const auto nextCoord = _getNextCoordForOrientation(currentState.coord, nextOrientation);
+            const size_t block = state / AxisCount;
+            if (block == destination) {
+                return loss;
+            }
 
-            if (_isValidNextCoord(nextCoord, input)) {
-                neighbors.emplace_back(_createNextState(nextCoord, nextOrientation, currentState, input));
+            const size_t row = block / input.nCols;
+            const size_t col = block % input.nCols;
+
+            // turn onto the other axis
+            const size_t nextAxis = state % AxisCount == Vertical ? Horizontal : Vertical;
+            const size_t lineLength = nextAxis == Vertical ? input.nRows : input.nCols;
+            const size_t linePos = nextAxis == Vertical ? row : col;
+            const ptrdiff_t stride = nextAxis == Vertical ? input.nCols : 1;
+
+            for (const ptrdiff_t direction : {-1, 1}) {
+                const size_t maxRun = min(constraints.maxStraightBlocks, direction < 0 ? linePos : lineLength - 1 - linePos);
+
+                uint32_t runLoss = loss;
+                size_t nextBlock = block;
+                for (size_t run = 1; run <= maxRun; run++) {
+                    nextBlock += direction * stride;
+                    runLoss += input.cityMap[nextBlock];
+                    if (run < constraints.minStraightBlocks) {
+                        continue;
+                    }
+
+                    const size_t nextState = nextBlock * AxisCount + nextAxis;
+                    if (runLoss < losses[nextState]) {
+                        losses[nextState] = runLoss;
+                        buckets[runLoss % buckets.size()].push_back(nextState);
+                        numQueued += 1;
+                    }
+                }
             }
         }
+        bucket.clear();
     }
 
-    return neighbors;
+    return kUnreachable;
 }
 
-VVVVULL _dijkstra(const coord_t &startCoord, const Input &input) {
-    // distances[coordX][coordY][orientation][straightBlocks]
-    VVVVULL losses = VVVVULL(input.nRows, VVVULL(input.nCols, VVULL(OrientationCount, VULL(input.maxStraightBlocks + 1, UINT64_MAX))));
-
-    loss_state_priority_queue_t toVisit;
-    for (size_t orientationIdx = 0; orientationIdx < OrientationCount; orientationIdx++) {
-        const auto orientation = static_cast<Orientation>(orientationIdx);
-        losses[startCoord.first][startCoord.second][orientation][0] = 0;
-
-        toVisit.emplace(LeastLossState {
-            .coord = startCoord,
-            .orientation = orientation,
-            .pathLoss = 0,
-            .straightBlocks = 0,
-        });
-    }
-
-    while (!toVisit.empty()) {
-        const auto currentState = toVisit.top();
-        toVisit.pop();
-
-        if (currentState.pathLoss > losses[currentState.coord.first][currentState.coord.second][currentState.orientation][currentState.straightBlocks]) {
-            continue;
-        }
-
-        const auto neighbors = _getNeighbors(currentState, input);
-        for (auto neighbor : neighbors) {
-            const auto neighborCost = input.cityMap[neighbor.coord.first][neighbor.coord.second];
-            const auto directLoss = losses[currentState.coord.first][currentState.coord.second][currentState.orientation][currentState.straightBlocks] + neighborCost;
-            if (directLoss < losses[neighbor.coord.first][neighbor.coord.second][neighbor.orientation][neighbor.straightBlocks]) {
-                losses[neighbor.coord.first][neighbor.coord.second][neighbor.orientation][neighbor.straightBlocks] = directLoss;
-                neighbor.pathLoss = directLoss;
-                toVisit.push(neighbor);
-            }
-        }
+void _printLeastHeatLoss(const Input &input, const CrucibleConstraints &constraints) {
+    const auto leastLoss = _leastHeatLoss(input, constraints);
+    if (leastLoss == kUnreachable) {
+        cout << "No path to the factory with straight runs of " << constraints.minStraightBlocks << " to " << constraints.maxStraightBlocks << " blocks" << endl;
+        exit(1);
     }
 
-    return losses;
+    cout << leastLoss << endl;
 }
 
 void part1(const Input &input) {
-    const auto destination = coord_t{input.nRows - 1, input.nCols - 1};
-
-    auto constraintsInput = input;
-    constraintsInput.minStraightBlocks = 1;
-    constraintsInput.maxStraightBlocks = 3;
-    const auto losses = _dijkstra({0, 0}, constraintsInput);
-
-    size_t leastLoss = UINT64_MAX;
-    for (size_t orientationIdx = 0; orientationIdx < OrientationCount; orientationIdx++) {
-        for (size_t straightBlocks = constraintsInput.minStraightBlocks; straightBlocks <= constraintsInput.maxStraightBlocks; straightBlocks++) {
-            leastLoss = min(losses[destination.first][destination.second][orientationIdx][straightBlocks], leastLoss);
-        }
-    }
-
-    cout << leastLoss << endl;
+    _printLeastHeatLoss(input, CrucibleConstraints{1, 3});
 }
 
 void part2(const Input &input) {
-    const auto destination = coord_t{input.nRows - 1, input.nCols - 1};
-
-    auto constraintsInput = input;
-    constraintsInput.minStraightBlocks = 4;
-    constraintsInput.maxStraightBlocks = 10;
-    const auto losses = _dijkstra({0, 0}, constraintsInput);
-
-    size_t leastLoss = UINT64_MAX;
-    for (size_t orientationIdx = 0; orientationIdx < OrientationCount; orientationIdx++) {
-        for (size_t straightBlocks = constraintsInput.minStraightBlocks; straightBlocks <= constraintsInput.maxStraightBlocks; straightBlocks++) {
-            leastLoss = min(losses[destination.first][destination.second][orientationIdx][straightBlocks], leastLoss);
-        }
-    }
-
-    cout << leastLoss << endl;
+    _printLeastHeatLoss(input, CrucibleConstraints{4, 10});
 }
 
 int main(int argc, char **argv) {
@@ -276,4 +185,4 @@ int main(int argc, char **argv) {
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
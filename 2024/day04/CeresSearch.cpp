@@ -3,16 +3,21 @@
 #include "../../util/Types.h"
 
 #include <vector>
-#include <optional>
-#include <stack>
-#include <set>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <unordered_map>
 
 using namespace std;
+using namespace std::chrono;
 using namespace aoc::util::types;
 
+#define BENCHMARK 0
+
 const string XMAS = "XMAS";
 
-const vector<coord_t> DIRECTIONS = {
+const vector<coord_signed_t> DIRECTIONS = {
     {-1, 0},  // up
     {-1, 1},  // up-right
     {0, 1},   // right
@@ -23,190 +28,177 @@ const vector<coord_t> DIRECTIONS = {
     {-1, -1}, // up-left
 };
 
-const vector<coord_t> FIRST_DIAG_DIRECTIONS = {
-    {-1, -1}, // up-left
-    {1, 1},   // down-right
-};
-
-const vector<coord_t> SECOND_DIAG_DIRECTIONS = {
-    {-1, 1},  // up-right
-    {1, -1},  // down-left
-};
-
-const set<vector<coord_t>> DIAGS = { FIRST_DIAG_DIRECTIONS, SECOND_DIAG_DIRECTIONS };
-
-struct SearchState {
-    size_t letterIdx = 0;
-    coord_t position;
-    optional<coord_t> direction;
-    set<coord_t> visitedPositions;
-};
-
-const optional<coord_t> getNextPosition(const coord_t &currentPosition, const coord_t &direction, const vector<string> &letterMap) {
-    const auto neighborPosition = make_pair(currentPosition.first + direction.first,
-                                            currentPosition.second + direction.second);
-
-    // check if new position is within map bounds
-    if (neighborPosition.first < 0 || neighborPosition.first >= letterMap.size() ||
-        neighborPosition.second < 0 || neighborPosition.second >= letterMap.front().size()) {
-        return nullopt;
-    }
+// One bitmap per letter: bit c of row r is set iff the grid has that letter at (r, c). Rows are
+// padded to whole 64-bit words, and the padding bits are always 0.
+struct LetterPlanes {
+    size_t width = 0;
+    size_t height = 0;
+    size_t wordsPerRow = 0;
+    unordered_map<char, vector<uint64_t>> planes;
+
+    LetterPlanes(const vector<string> &letterMap, const string &letters) {
+        height = letterMap.size();
+        for (const auto &line : letterMap) {
+            width = max(width, line.size());
+        }
+        wordsPerRow = (width + 63) / 64;
 
-    return neighborPosition;
-}
+        for (const char letter : letters) {
+            planes[letter].assign(height * wordsPerRow, 0);
+        }
 
-const optional<SearchState> isDirectionValid(const SearchState &currentState, const coord_t &direction, const vector<string> &letterMap, const string &searchWord) {
-    const auto neighborPositionOpt = getNextPosition(currentState.position, direction, letterMap);
-    if (!neighborPositionOpt) {
-        return nullopt;
+        for (size_t row = 0; row < height; row++) {
+            const auto &line = letterMap[row];
+            for (size_t col = 0; col < line.size(); col++) {
+                const auto it = planes.find(line[col]);
+                if (it != planes.end()) {
+                    it->second[row * wordsPerRow + col / 64] |= 1ull << (col % 64);
+                }
+            }
+        }
     }
 
-    const auto neighborPosition = *neighborPositionOpt;
-
-    // check if we've already been in that position
-    if (currentState.visitedPositions.contains(neighborPosition)) {
-        return nullopt;
+    const uint64_t *row(const char letter, const size_t rowIdx) const {
+        return planes.at(letter).data() + rowIdx * wordsPerRow;
     }
+};
 
-    // check if this position has a letter we are interested in
-    const auto nextLetterIdx = currentState.letterIdx + 1;
-    const auto desiredLetter = searchWord[nextLetterIdx];
-    if (letterMap[neighborPosition.first][neighborPosition.second] != desiredLetter) {
-        return nullopt;
-    }
+// out gets the row moved by shift columns: bit c of out is bit (c + shift) of the row, or 0 when
+// that is outside of it.
+void shiftRow(const uint64_t *row, const size_t wordsPerRow, const int64_t shift, uint64_t *out) {
+    const int64_t wordShift = shift >= 0 ? shift / 64 : -((-shift + 63) / 64);
+    const int64_t bitShift = shift - wordShift * 64;  // in [0, 64)
 
-    SearchState nextState = {
-        .letterIdx = nextLetterIdx,
-        .position = neighborPosition,
-        .direction = direction,
-        .visitedPositions = currentState.visitedPositions,
+    const auto wordAt = [&](const int64_t idx) -> uint64_t {
+        return idx >= 0 && idx < int64_t(wordsPerRow) ? row[idx] : 0;
     };
-    nextState.visitedPositions.insert(nextState.position);
-
-    return nextState;
-}
 
-size_t countWordDFS(const vector<string> &letterMap, const string &searchWord, const vector<coord_t> &startPositions) {
-    stack<SearchState> statesToVisit;
-
-    for (const auto &startPosition : startPositions) {
-        set<coord_t> visitedPositions { startPosition };
-        statesToVisit.push(SearchState {
-            .letterIdx = 0,
-            .position = startPosition,
-            .direction = nullopt,
-            .visitedPositions = visitedPositions,
-        });
+    for (int64_t w = 0; w < int64_t(wordsPerRow); w++) {
+        const uint64_t low = wordAt(w + wordShift);
+        const uint64_t high = wordAt(w + wordShift + 1);
+        out[w] = bitShift == 0 ? low : (low >> bitShift) | (high << (64 - bitShift));
     }
+}
 
-    size_t wordCount = 0;
-    while (!statesToVisit.empty()) {
-        const auto currentState = statesToVisit.top();
-        statesToVisit.pop();
+// A match of the word starting at (r, c) in direction (dr, dc) needs letter k at (r + k dr, c + k dc):
+// with the plane of each letter shifted back by k dc columns, the matches of a whole row of starts
+// are the AND of the planes of rows r, r + dr, ... which handles 64 starts per word operation.
+size_t countWord(const LetterPlanes &planes, const string &searchWord) {
+    const size_t wordLength = searchWord.size();
+    const int64_t span = wordLength - 1;
 
-        if (currentState.letterIdx == searchWord.size() - 1) {
-            wordCount += 1;
-            continue;
-        }
+    vector<uint64_t> matches(planes.wordsPerRow);
+    vector<uint64_t> shifted(planes.wordsPerRow);
 
-        if (!currentState.direction) {
-            // find the next letter in all directions
-            for (const auto &direction : DIRECTIONS) {
-                const auto nextStateOpt = isDirectionValid(currentState, direction, letterMap, searchWord);
-                if (!nextStateOpt) {
-                    continue;
+    size_t wordCount = 0;
+    for (const auto &[dr, dc] : DIRECTIONS) {
+        const int64_t minRow = dr < 0 ? span : 0;
+        const int64_t maxRow = int64_t(planes.height) - (dr > 0 ? span : 0);
+
+        for (int64_t r = minRow; r < maxRow; r++) {
+            fill(matches.begin(), matches.end(), ~0ull);
+            for (size_t k = 0; k < wordLength; k++) {
+                shiftRow(planes.row(searchWord[k], r + k * dr), planes.wordsPerRow, k * dc, shifted.data());
+                for (size_t w = 0; w < planes.wordsPerRow; w++) {
+                    matches[w] &= shifted[w];
                 }
-
-                statesToVisit.push(*nextStateOpt);
-            }
-        } else {
-            // we force a specific direction and only look in that direction
-            const auto nextStateOpt = isDirectionValid(currentState, *currentState.direction, letterMap, searchWord);
-            if (!nextStateOpt) {
-                continue;
             }
 
-            statesToVisit.push(*nextStateOpt);
+            for (const auto word : matches) {
+                wordCount += popcount(word);
+            }
         }
     }
 
     return wordCount;
 }
 
-void part1(istream& inputFile) {
-    vector<string> letters;
-    vector<coord_t> startPositions;
-
-    size_t rowIdx = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+// An X-MAS is an A whose two diagonals each read MAS or SAM: per row of centers, each diagonal is
+// (M above and S below) or (S above and M below), the rows above and below shifted by one column.
+size_t countXmas(const LetterPlanes &planes) {
+    const size_t wpr = planes.wordsPerRow;
 
-        letters.push_back(line);
+    array<vector<uint64_t>, 8> shifted;
+    for (auto &s : shifted) {
+        s.resize(wpr);
+    }
+    auto &mUpLeft = shifted[0], &sUpLeft = shifted[1], &mUpRight = shifted[2], &sUpRight = shifted[3];
+    auto &mDownLeft = shifted[4], &sDownLeft = shifted[5], &mDownRight = shifted[6], &sDownRight = shifted[7];
 
-        const auto colIds = aoc::util::string::findAllPositions(line, XMAS[0]);
-        for (const auto &colIdx : colIds) {
-            startPositions.emplace_back(make_pair(rowIdx, colIdx));
+    size_t xmasCount = 0;
+    for (size_t r = 1; r + 1 < planes.height; r++) {
+        shiftRow(planes.row('M', r - 1), wpr, -1, mUpLeft.data());
+        shiftRow(planes.row('S', r - 1), wpr, -1, sUpLeft.data());
+        shiftRow(planes.row('M', r - 1), wpr, 1, mUpRight.data());
+        shiftRow(planes.row('S', r - 1), wpr, 1, sUpRight.data());
+        shiftRow(planes.row('M', r + 1), wpr, -1, mDownLeft.data());
+        shiftRow(planes.row('S', r + 1), wpr, -1, sDownLeft.data());
+        shiftRow(planes.row('M', r + 1), wpr, 1, mDownRight.data());
+        shiftRow(planes.row('S', r + 1), wpr, 1, sDownRight.data());
+
+        const uint64_t *centers = planes.row('A', r);
+        for (size_t w = 0; w < wpr; w++) {
+            const uint64_t firstDiagonal = (mUpLeft[w] & sDownRight[w]) | (sUpLeft[w] & mDownRight[w]);
+            const uint64_t secondDiagonal = (mUpRight[w] & sDownLeft[w]) | (sUpRight[w] & mDownLeft[w]);
+            xmasCount += popcount(centers[w] & firstDiagonal & secondDiagonal);
         }
+    }
+
+    return xmasCount;
+}
+
+void _benchmark() {
+    constexpr size_t kGridSize = 10000;
 
-        rowIdx += 1;
+    mt19937 rng(4);
+    vector<string> letters(kGridSize, string(kGridSize, 'X'));
+    for (auto &line : letters) {
+        for (auto &ch : line) {
+            ch = XMAS[rng() % XMAS.size()];
+        }
     }
 
-    cout << countWordDFS(letters, XMAS, startPositions) << endl;
+    auto t1 = high_resolution_clock::now();
+    const LetterPlanes planes(letters, XMAS);
+    auto t2 = high_resolution_clock::now();
+    const auto wordCount = countWord(planes, XMAS);
+    auto t3 = high_resolution_clock::now();
+    const auto xmasCount = countXmas(planes);
+    auto t4 = high_resolution_clock::now();
+
+    const double numCells = kGridSize * kGridSize;
+    cout << "Benchmark (" << kGridSize << "x" << kGridSize << " grid):" << endl;
+    cout << "Planes: " << numCells / duration<double>(t2 - t1).count() << " cells/s" << endl;
+    cout << "XMAS:   " << numCells / duration<double>(t3 - t2).count() << " cells/s (" << wordCount << " matches)" << endl;
+    cout << "X-MAS:  " << numCells / duration<double>(t4 - t3).count() << " cells/s (" << xmasCount << " matches)" << endl;
 }
 
-void part2(istream& inputFile) {
+const vector<string> readLetters(istream& inputFile) {
     vector<string> letters;
-    vector<coord_t> startPositions;
-
-    size_t rowIdx = 0;
     while (!inputFile.eof()) {
         string line;
         getline(inputFile, line);
 
-        letters.push_back(line);
-
-        const auto colIds = aoc::util::string::findAllPositions(line, XMAS[2]);
-        for (const auto &colIdx : colIds) {
-            startPositions.emplace_back(make_pair(rowIdx, colIdx));
+        if (!line.empty()) {
+            letters.push_back(line);
         }
-
-        rowIdx += 1;
     }
 
-    size_t xmasCount = 0;
-    for (const auto &position : startPositions) {
-        bool badXmas = false;
-        for (const auto &diagDirections : DIAGS) {
-            if (badXmas) {
-                break;
-            }
-
-            set<char> requiredLetters = {'M', 'S'};
-            for (const auto &direction : diagDirections) {
-                const auto nextPositionOpt = getNextPosition(position, direction, letters);
-                if (!nextPositionOpt) {
-                    badXmas = true;
-                    break;
-                }
+    return letters;
+}
 
-                const auto nextPosition = *nextPositionOpt;
-                const auto nextPositionLetter = letters[nextPosition.first][nextPosition.second];
-                if (!requiredLetters.contains(nextPositionLetter)) {
-                    badXmas = true;
-                    break;
-                }
+void part1(istream& inputFile) {
+    const LetterPlanes planes(readLetters(inputFile), XMAS);
+    cout << countWord(planes, XMAS) << endl;
+}
 
-                requiredLetters.erase(nextPositionLetter);
-            }
-        }
+void part2(istream& inputFile) {
+    const LetterPlanes planes(readLetters(inputFile), "MAS");
+    cout << countXmas(planes) << endl;
 
-        if (!badXmas) {
-            xmasCount += 1;
-        }
+    if (BENCHMARK) {
+        _benchmark();
     }
-
-    cout << xmasCount << endl;
 }
 
 int main(int argc, char **argv) {
@@ -231,4 +223,4 @@ int main(int argc, char **argv) {
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
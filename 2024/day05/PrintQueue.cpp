@@ -1,19 +1,46 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/StringUtil.h"
+#include "../../util/Parallel.h"
 
-#include <set>
-#include <map>
+#include <array>
+#include <bitset>
+#include <optional>
 #include <regex>
+#include <vector>
 
 using namespace std;
+using namespace aoc::util::parallel;
 
 const regex ORDERING_RX("([0-9]+)\\|([0-9]+)");
 
-void _printRules(const map<size_t, set<size_t>> &rules) {
-    for (const auto &rule : rules) {
-        cout << rule.first << ": { ";
-        for (const auto &pageNumber : rule.second) {
-            cout << pageNumber << " ";
+constexpr size_t MAX_PAGE_NUMBER = 100;  // page numbers have two digits
+
+typedef bitset<MAX_PAGE_NUMBER> page_set_t;
+
+// The rules as two bit matrices: mustPrecede[a] holds every b with a rule "a|b", and mustFollow[b]
+// every a, so checking a pair is a single bit test and checking a page against a whole set of
+// pages a single AND.
+struct OrderingRules {
+    array<page_set_t, MAX_PAGE_NUMBER> mustPrecede;
+    array<page_set_t, MAX_PAGE_NUMBER> mustFollow;
+};
+
+struct Manual {
+    OrderingRules rules;
+    vector<vector<size_t>> updates;
+};
+
+void _printRules(const OrderingRules &rules) {
+    for (size_t page = 0; page < MAX_PAGE_NUMBER; ++page) {
+        if (rules.mustPrecede[page].none()) {
+            continue;
+        }
+
+        cout << page << ": { ";
+        for (size_t pageNumber = 0; pageNumber < MAX_PAGE_NUMBER; ++pageNumber) {
+            if (rules.mustPrecede[page][pageNumber]) {
+                cout << pageNumber << " ";
+            }
         }
         cout << "}" <<endl;
     }
@@ -29,9 +56,16 @@ void _printUpdates(const vector<vector<size_t>> &updates) {
     }
 }
 
-void part1(istream& inputFile) {
-    map<size_t, set<size_t>> orderingRules;
-    vector<vector<size_t>> updates;
+size_t _checkPageNumber(const size_t pageNumber) {
+    if (pageNumber >= MAX_PAGE_NUMBER) {
+        cout << "Page number " << pageNumber << " has more than two digits!" << endl;
+        exit(1);
+    }
+    return pageNumber;
+}
+
+const Manual _readManual(istream& inputFile) {
+    Manual manual;
 
     while (!inputFile.eof()) {
         string line;
@@ -43,12 +77,14 @@ void part1(istream& inputFile) {
 
         smatch match;
         if (regex_match(line, match, ORDERING_RX)) {
-            const size_t numA = stoul(match[1].str());
-            const size_t numB = stoul(match[2].str());
+            const size_t numA = _checkPageNumber(stoul(match[1].str()));
+            const size_t numB = _checkPageNumber(stoul(match[2].str()));
 
-            orderingRules[numA].insert(numB);
+            manual.rules.mustPrecede[numA].set(numB);
+            manual.rules.mustFollow[numB].set(numA);
         } else {
             vector<size_t> update;
+            page_set_t listedPages;
 
             istringstream iss(line);
             size_t pageNumber;
@@ -56,114 +92,118 @@ void part1(istream& inputFile) {
                 if (iss.peek() == ',') {
                     iss.ignore();
                 }
-                update.push_back(pageNumber);
-            }
 
-            updates.push_back(update);
-        }
-    }
-
-    // _printRules(orderingRules);
-    // _printUpdates(updates);
-
-    size_t midPageNumberSum = 0;
-    for (const auto &update : updates) {
-        bool isValid = true;
-        for (size_t i = 0; i < update.size() - 1 && isValid; ++i) {
-            for (size_t j = i + 1; j < update.size() && isValid; ++j) {
-                const auto numA = update[i];
-                const auto numB = update[j];
-
-                if (orderingRules[numB].contains(numA)) {
-                    // ordering is reversed, we are not good, stop
-                    isValid = false;
-                    break;
+                // a page printed twice has no single place in the ordering
+                if (listedPages[_checkPageNumber(pageNumber)]) {
+                    cout << "Update { " << line << " } lists page " << pageNumber << " more than once!" << endl;
+                    exit(1);
                 }
+                listedPages.set(pageNumber);
+
+                update.push_back(pageNumber);
             }
-        }
 
-        if (isValid) {
-            midPageNumberSum += update[update.size() / 2];
+            manual.updates.push_back(update);
         }
     }
 
-    cout << midPageNumberSum << endl;
+    return manual;
 }
 
-const pair<bool, vector<size_t>> _fixOrdering(const vector<size_t> &update, map<size_t, set<size_t>> &orderingRules) {
-    vector<size_t> orderedUpdate = update;
-
-    bool fixedOrder = false;
-    for (size_t i = 0; i < orderedUpdate.size() - 1; ++i) {
-        bool updateDone = true;
-        while (updateDone) {
-            updateDone = false;
-            for (size_t j = i + 1; j < orderedUpdate.size(); ++j) {
-                const size_t numA = orderedUpdate[i];
-                const size_t numB = orderedUpdate[j];
-
-                if (orderingRules[numB].contains(numA)) {
-                    // ordering is reversed, we are not good, reorder
-                    orderedUpdate[i] = numB;
-                    orderedUpdate[j] = numA;
-
-                    updateDone = true;
-                    fixedOrder = true;
-                }
-            }
+// Single scan: an update is out of order iff some page must precede a page already printed.
+bool _isOrdered(const vector<size_t> &update, const OrderingRules &rules) {
+    page_set_t printed;
+    for (const auto page : update) {
+        if ((rules.mustPrecede[page] & printed).any()) {
+            return false;
         }
+        printed.set(page);
     }
-
-    return make_pair(fixedOrder, orderedUpdate);
+    return true;
 }
 
-void part2(istream& inputFile) {
-    map<size_t, set<size_t>> orderingRules;
-    vector<vector<size_t>> updates;
+// Kahn's algorithm restricted to the pages of the update (which are all distinct): the next page is
+// the first one (in the update's order) that no remaining page has to precede. Returns nothing when
+// the rules between the pages have a cycle.
+optional<vector<size_t>> _repairOrdering(const vector<size_t> &update, const OrderingRules &rules) {
+    page_set_t remaining;
+    for (const auto page : update) {
+        remaining.set(page);
+    }
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+    vector<size_t> orderedUpdate;
+    orderedUpdate.reserve(update.size());
+    while (orderedUpdate.size() < update.size()) {
+        size_t nextPage = MAX_PAGE_NUMBER;
+        for (const auto page : update) {
+            if (remaining[page] && (rules.mustFollow[page] & remaining).none()) {
+                nextPage = page;
+                break;
+            }
+        }
 
-        if (line.empty()) {
-            continue;
+        if (nextPage == MAX_PAGE_NUMBER) {
+            return nullopt;
         }
 
-        smatch match;
-        if (regex_match(line, match, ORDERING_RX)) {
-            const size_t numA = stoul(match[1].str());
-            const size_t numB = stoul(match[2].str());
+        remaining.reset(nextPage);
+        orderedUpdate.push_back(nextPage);
+    }
 
-            orderingRules[numA].insert(numB);
-        } else {
-            vector<size_t> update;
+    return orderedUpdate;
+}
 
-            istringstream iss(line);
-            size_t pageNumber;
-            while (iss >> pageNumber) {
-                if (iss.peek() == ',') {
-                    iss.ignore();
-                }
-                update.push_back(pageNumber);
+// Sum of the middle pages of the updates already in order, or of the repaired ones that were not.
+// The workers only flag the updates that can not be repaired; they are reported once all are joined.
+size_t _sumMiddlePages(const Manual &manual, const bool repairedUpdates) {
+    vector<size_t> middlePages(manual.updates.size(), 0);
+    vector<uint8_t> isUnrepairable(manual.updates.size(), 0);
+    parallelFor(manual.updates.size(), [&](const size_t i) {
+        const auto &update = manual.updates[i];
+        if (update.empty()) {
+            return;
+        }
+
+        const bool isOrdered = _isOrdered(update, manual.rules);
+        if (isOrdered && !repairedUpdates) {
+            middlePages[i] = update[update.size() / 2];
+        } else if (!isOrdered && repairedUpdates) {
+            const auto orderedUpdate = _repairOrdering(update, manual.rules);
+            if (!orderedUpdate) {
+                isUnrepairable[i] = 1;
+                return;
             }
+            middlePages[i] = (*orderedUpdate)[update.size() / 2];
+        }
+    });
 
-            updates.push_back(update);
+    for (size_t i = 0; i < isUnrepairable.size(); i++) {
+        if (isUnrepairable[i]) {
+            cout << "Ordering rules have a cycle, update " << i << " can not be ordered!" << endl;
+            exit(1);
         }
     }
 
-    // _printRules(orderingRules);
-    // _printUpdates(updates);
-
     size_t midPageNumberSum = 0;
-    for (const auto &update : updates) {
-        const auto res = _fixOrdering(update, orderingRules);
-
-        if (res.first) {
-            midPageNumberSum += res.second[res.second.size() / 2];
-        }
+    for (const auto page : middlePages) {
+        midPageNumberSum += page;
     }
+    return midPageNumberSum;
+}
 
-    cout << midPageNumberSum << endl;
+void part1(istream& inputFile) {
+    const auto manual = _readManual(inputFile);
+
+    // _printRules(manual.rules);
+    // _printUpdates(manual.updates);
+
+    cout << _sumMiddlePages(manual, false) << endl;
+}
+
+void part2(istream& inputFile) {
+    const auto manual = _readManual(inputFile);
+
+    cout << _sumMiddlePages(manual, true) << endl;
 }
 
 int main(int argc, char **argv) {
@@ -188,4 +228,4 @@ int main(int argc, char **argv) {
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -2,202 +2,195 @@
 #include "../../util/StringUtil.h"
 #include "../../util/Types.h"
 #include "../../util/Graph.h"
+#include "../../util/Parallel.h"
 
 #include <vector>
-#include <map>
-#include <set>
-#include <queue>
 
 using namespace std;
 using namespace aoc::util::types;
 using namespace aoc::util::graph;
+using namespace aoc::util::parallel;
 
-struct Region {
-    char type;
-    coord_t startPosition;
+// Minimum number of rows a band has to have before we bother splitting the garden between threads.
+constexpr size_t kMinBandRows = 64;
 
-    size_t area;
-    size_t perimeter;
+struct Garden {
+    size_t h = 0;
+    size_t w = 0;
+    vector<char> plots;  // flat, row-major
 
-    vector<coord_t> topEdgePositions;
-    vector<coord_t> rightEdgePositions;
-    vector<coord_t> bottomEdgePositions;
-    vector<coord_t> leftEdgePositions;
-
-    bool operator<(const Region &other) const {
-        return tie(type, startPosition) < tie(other.type, other.startPosition);
+    char at(const int64_t row, const int64_t col) const {
+        if (row < 0 || row >= (int64_t)h || col < 0 || col >= (int64_t)w) {
+            return 0;
+        }
+        return plots[row * w + col];
     }
 };
 
-void _printPositions(const map<char, set<coord_t>> &typeToPositions) {
-    for (const auto &p : typeToPositions) {
-        cout << p.first << ": ";
-        for (const auto &pos : p.second) {
-            cout << "{" << pos.first << "," << pos.second << "} ";
+// Region labeling via union-find over the flat grid: every region is identified by its root cell,
+// and its area / perimeter / corner count are accumulated at that root's index, so there are no
+// per-region containers. Sides of a polygon = corners of the polygon.
+struct Regions {
+    vector<uint32_t> parent;
+    vector<uint32_t> area;
+    vector<uint32_t> perimeter;
+    vector<uint32_t> corners;
+
+    uint32_t find(uint32_t idx) {
+        while (parent[idx] != idx) {
+            parent[idx] = parent[parent[idx]];
+            idx = parent[idx];
         }
-        cout << endl;
+        return idx;
     }
-}
 
-void _printGarden(const vector<string> &garden) {
-    for (const auto &line : garden) {
-        cout << line << endl;
+    void unite(const uint32_t a, const uint32_t b) {
+        const auto rootA = find(a);
+        const auto rootB = find(b);
+        if (rootA == rootB) {
+            return;
+        }
+        // always keep the smallest (first in scan order) cell as root
+        parent[max(rootA, rootB)] = min(rootA, rootB);
+    }
+};
+
+void _printGarden(const Garden &garden) {
+    for (size_t row = 0; row < garden.h; ++row) {
+        cout << string(garden.plots.begin() + row * garden.w, garden.plots.begin() + (row + 1) * garden.w) << endl;
     }
 }
 
-const set<coord_t> _getNextPositions(const coord_t currentPosition, const size_t gardenH, const size_t gardenW) {
-    set<coord_t> validNextPositions;
+const Garden _parseGarden(istream& inputFile) {
+    Garden garden;
 
-    const coord_signed_t signedCurrentPosition = currentPosition;
-    for (const auto &dir : kCompassDirections4) {
-        const coord_signed_t nextPosition = {signedCurrentPosition.first + dir.first, signedCurrentPosition.second + dir.second};
-        if (nextPosition.first < 0 || nextPosition.first >= gardenH ||
-            nextPosition.second < 0 || nextPosition.second >= gardenW) {
-                continue;
+    while (!inputFile.eof()) {
+        string line;
+        getline(inputFile, line);
+
+        if (line.empty()) {
+            continue;
         }
 
-        validNextPositions.insert(nextPosition);
+        garden.w = line.size();
+        garden.plots.insert(garden.plots.end(), line.begin(), line.end());
+        garden.h += 1;
     }
 
-    return validNextPositions;
+    return garden;
 }
 
-const size_t _countSides(const vector<coord_t> &edgePositions, bool isHorizontal = false) {
-    map<size_t, vector<size_t>> edgeCoordToEdgeStretchIdx;
-    for (const auto &pos : edgePositions) {
-        if (isHorizontal) {
-            if (!edgeCoordToEdgeStretchIdx.contains(pos.first)) {
-                edgeCoordToEdgeStretchIdx[pos.first] = vector<size_t>();
-            }
-            edgeCoordToEdgeStretchIdx[pos.first].push_back(pos.second);
-        } else {
-            if (!edgeCoordToEdgeStretchIdx.contains(pos.second)) {
-                edgeCoordToEdgeStretchIdx[pos.second] = vector<size_t>();
+// Scanline labeling of rows [startRow, endRow): every run of equal plots in a row shares the label of
+// its first cell, and runs are united with matching plots in the row above (within the band).
+void _labelBand(const Garden &garden, const size_t startRow, const size_t endRow, Regions &regions) {
+    for (size_t row = startRow; row < endRow; ++row) {
+        size_t runStart = 0;
+        for (size_t col = 0; col < garden.w; ++col) {
+            const uint32_t idx = row * garden.w + col;
+            const char type = garden.plots[idx];
+
+            if (col > 0 && garden.plots[idx - 1] == type) {
+                regions.parent[idx] = runStart;
+            } else {
+                runStart = idx;
+                regions.parent[idx] = idx;
             }
-            edgeCoordToEdgeStretchIdx[pos.second].push_back(pos.first);
-        }
-    }
 
-    // for (const auto &p : edgeCoordToEdgeStretchIdx) {
-    //     cout << p.first << " -> { ";
-    //     for (const auto &idx : p.second) {
-    //         cout << idx << " ";
-    //     }
-    //     cout << " }" << endl;
-    // }
-
-    size_t numEdges = 0;
-    for (const auto &p : edgeCoordToEdgeStretchIdx) {
-        numEdges += 1;
-        auto edgeStretchIndices = p.second;
-        sort(edgeStretchIndices.begin(), edgeStretchIndices.end());
-        for (size_t i = 0; i < edgeStretchIndices.size() - 1; ++i) {
-            if (edgeStretchIndices[i + 1] - edgeStretchIndices[i] != 1) {
-                numEdges += 1;
+            if (row > startRow && garden.plots[idx - garden.w] == type) {
+                regions.unite(idx, idx - garden.w);
             }
         }
     }
-
-    return numEdges;
 }
 
-const optional<coord_t> _getNextPosition(const kCompass4Orientation orientation, coord_signed_t currentPosition, const char type, const vector<string> &garden, const size_t gardenH, const size_t gardenW) {
-    const auto dir = kCompassDirections4[orientation];
-    const coord_signed_t nextPosition = {currentPosition.first + dir.first, currentPosition.second + dir.second};
+// Perimeter and corner contributions of a single plot, only looking at its 8 neighbours.
+void _measurePlot(const Garden &garden, const int64_t row, const int64_t col, uint32_t &perimeter, uint32_t &corners) {
+    const char type = garden.at(row, col);
 
-    if (nextPosition.first < 0 || nextPosition.first >= gardenH ||
-        nextPosition.second < 0 || nextPosition.second >= gardenW) {
-        return nullopt;
-    }
-
-    if (garden[nextPosition.first][nextPosition.second] != type) {
-        return nullopt;
+    perimeter = 0;
+    for (const auto &dir : kCompassDirections4) {
+        perimeter += garden.at(row + dir.first, col + dir.second) != type;
     }
 
-    return nextPosition;
-}
-
-const Region _fillRegionBFS(const char type, const coord_signed_t startPosition, const vector<string> &garden, vector<vector<bool>> &visited) {
-    Region region = {
-        .type = type,
-        .startPosition = startPosition,
-    };
-
-    const size_t gardenH = garden.size();
-    const size_t gardenW = garden.front().size();
+    corners = 0;
+    for (const int64_t dRow : {-1, 1}) {
+        for (const int64_t dCol : {-1, 1}) {
+            const bool sameVertical = garden.at(row + dRow, col) == type;
+            const bool sameHorizontal = garden.at(row, col + dCol) == type;
+            const bool sameDiagonal = garden.at(row + dRow, col + dCol) == type;
 
-    queue<coord_t> positionsToVisit;
-    positionsToVisit.push(startPosition);
-
-    while (!positionsToVisit.empty()) {
-        const auto currentPosition = positionsToVisit.front();
-        positionsToVisit.pop();
-
-        if (visited[currentPosition.first][currentPosition.second]) {
-            continue;
+            // convex corner, or concave corner with the diagonal plot belonging to someone else
+            corners += (!sameVertical && !sameHorizontal) || (sameVertical && sameHorizontal && !sameDiagonal);
         }
+    }
+}
 
-        visited[currentPosition.first][currentPosition.second] = true;
-        region.area += 1;
-
-        set<coord_t> nextPositions;
-        for (size_t orientation = 0; orientation < kCompass4Orientation::kCount; ++orientation) {
-            const auto nextPositionOpt = _getNextPosition((kCompass4Orientation)orientation, currentPosition, type, garden, gardenH, gardenW);
-            if (nextPositionOpt) {
-                nextPositions.insert(*nextPositionOpt);
-                continue;
-            }
-
-            const kCompass4Orientation compassOrientation = (kCompass4Orientation)orientation;
-            if (compassOrientation == kCompass4Orientation::kNorth) {
-                region.topEdgePositions.push_back(currentPosition);
-            }
-
-            if (compassOrientation == kCompass4Orientation::kEast) {
-                region.rightEdgePositions.push_back(currentPosition);
-            }
-
-            if (compassOrientation == kCompass4Orientation::kSouth) {
-                region.bottomEdgePositions.push_back(currentPosition);
-            }
-
-            if (compassOrientation == kCompass4Orientation::kWest) {
-                region.leftEdgePositions.push_back(currentPosition);
+// Labels all the regions of the garden in horizontal bands (one per worker) and merges the band
+// labels at the seams; per-plot measurements are accumulated at band roots first, then folded
+// into the final region roots.
+Regions _getRegions(const Garden &garden) {
+    const size_t numCells = garden.h * garden.w;
+
+    Regions regions;
+    regions.parent.resize(numCells);
+    regions.area.assign(numCells, 0);
+    regions.perimeter.assign(numCells, 0);
+    regions.corners.assign(numCells, 0);
+
+    const size_t numBands = getNumWorkers(garden.h / kMinBandRows);
+    const size_t bandRows = (garden.h + numBands - 1) / numBands;
+
+    vector<vector<uint32_t>> bandRoots(numBands);
+    parallelFor(numBands, [&](const size_t bandIdx) {
+        const size_t startRow = min(garden.h, bandIdx * bandRows);
+        const size_t endRow = min(garden.h, startRow + bandRows);
+
+        _labelBand(garden, startRow, endRow, regions);
+
+        for (size_t row = startRow; row < endRow; ++row) {
+            for (size_t col = 0; col < garden.w; ++col) {
+                const uint32_t idx = row * garden.w + col;
+                const auto root = regions.find(idx);
+                if (root == idx) {
+                    bandRoots[bandIdx].push_back(root);
+                }
+
+                uint32_t perimeter, corners;
+                _measurePlot(garden, row, col, perimeter, corners);
+
+                regions.area[root] += 1;
+                regions.perimeter[root] += perimeter;
+                regions.corners[root] += corners;
             }
         }
+    });
 
-        for (const auto &nextPosition : nextPositions) {
-            if (garden[nextPosition.first][nextPosition.second] != type) {
-                continue;
-            }
+    // stitch the bands together along their seams
+    for (size_t bandIdx = 1; bandIdx < numBands; ++bandIdx) {
+        const size_t seamRow = bandIdx * bandRows;
+        if (seamRow >= garden.h) {
+            break;
+        }
 
-            if (visited[nextPosition.first][nextPosition.second]) {
-                continue;
+        for (size_t col = 0; col < garden.w; ++col) {
+            const uint32_t idx = seamRow * garden.w + col;
+            if (garden.plots[idx] == garden.plots[idx - garden.w]) {
+                regions.unite(idx, idx - garden.w);
             }
-
-            positionsToVisit.push(nextPosition);
         }
     }
 
-    return region;
-}
-
-const set<Region> _getRegions(const map<char, set<coord_t>> &typeToPositions, const vector<string> &garden) {
-    set<Region> regions;
-
-    vector<vector<bool>> visitedPositions = vector<vector<bool>>(garden.size(), vector<bool>(garden.front().size(), false));
-
-    for (const auto &p : typeToPositions) {
-        const char type = p.first;
-        const auto currentTypePositions = p.second;
-
-        for (const auto &startPosition : currentTypePositions) {
-            if (visitedPositions[startPosition.first][startPosition.second]) {
+    for (const auto &roots : bandRoots) {
+        for (const auto bandRoot : roots) {
+            const auto root = regions.find(bandRoot);
+            if (root == bandRoot) {
                 continue;
             }
 
-            const auto region = _fillRegionBFS(type, startPosition, garden, visitedPositions);
-            regions.insert(region);
+            regions.area[root] += regions.area[bandRoot];
+            regions.perimeter[root] += regions.perimeter[bandRoot];
+            regions.corners[root] += regions.corners[bandRoot];
+            regions.area[bandRoot] = 0;
         }
     }
 
@@ -205,95 +198,36 @@ const set<Region> _getRegions(const map<char, set<coord_t>> &typeToPositions, co
 }
 
 void part1(istream& inputFile) {
-    map<char, set<coord_t>> typeToPositions;
-    vector<string> garden;
+    const auto garden = _parseGarden(inputFile);
 
-    size_t rowIdx = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        for (size_t colIdx = 0; colIdx < line.size(); ++colIdx) {
-            const auto ch = line[colIdx];
-            typeToPositions[ch].insert({rowIdx, colIdx});
-        }
-
-        garden.push_back(line);
-        rowIdx += 1;
-    }
-
-    // _printPositions(typeToPositions);
-    // cout << endl;
     // _printGarden(garden);
     // cout << endl;
 
-    const auto regions = _getRegions(typeToPositions, garden);
+    auto regions = _getRegions(garden);
 
     size_t totalPrice = 0;
-    for (auto &region : regions) {
-        const auto perimeter = region.topEdgePositions.size() + region.rightEdgePositions.size() + region.bottomEdgePositions.size() + region.leftEdgePositions.size();
-        // cout << region.type << ": a=" << region.area
-        //     << " p(top)=" << region.topEdgePositions.size()
-        //     << " p(right)=" << region.rightEdgePositions.size()
-        //     << " p(bottom)=" << region.bottomEdgePositions.size()
-        //     << " p(left)=" << region.leftEdgePositions.size()
-        //     << " p= " << perimeter << endl;
-
-        totalPrice += region.area * perimeter;
+    for (size_t idx = 0; idx < regions.parent.size(); ++idx) {
+        if (regions.find(idx) == idx) {
+            totalPrice += (size_t)regions.area[idx] * regions.perimeter[idx];
+        }
     }
 
     cout << totalPrice << endl;
 }
 
 void part2(istream& inputFile) {
-    map<char, set<coord_t>> typeToPositions;
-    vector<string> garden;
-
-    size_t rowIdx = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        for (size_t colIdx = 0; colIdx < line.size(); ++colIdx) {
-            const auto ch = line[colIdx];
-            typeToPositions[ch].insert({rowIdx, colIdx});
-        }
+    const auto garden = _parseGarden(inputFile);
 
-        garden.push_back(line);
-        rowIdx += 1;
-    }
-
-    // _printPositions(typeToPositions);
-    // cout << endl;
     // _printGarden(garden);
     // cout << endl;
 
-    const auto regions = _getRegions(typeToPositions, garden);
+    auto regions = _getRegions(garden);
 
     size_t totalPrice = 0;
-    for (const auto &region : regions) {
-        // cout << "region=" << region.type << endl;
-        // cout << "topSides:" << endl;
-        const auto topSides = _countSides(region.topEdgePositions, true);
-
-        // cout << "rightSides:" << endl;
-        const auto rightSides = _countSides(region.rightEdgePositions, false);
-
-        // cout << "bottomSides:" << endl;
-        const auto bottomSides = _countSides(region.bottomEdgePositions, true);
-
-        // cout << "leftSides:" << endl;
-        const auto leftSides = _countSides(region.leftEdgePositions, false);
-
-        const auto totalSides = topSides + rightSides + bottomSides + leftSides;
-        // cout << region.type << ": a=" << region.area
-        //     << " sides(top)=" << topSides
-        //     << " sides(right)=" << rightSides
-        //     << " sides(bottom)=" << bottomSides
-        //     << " sides(left)=" << leftSides
-        //     << " totalSides=" << totalSides << endl << endl;
-
-        totalPrice += region.area * totalSides;
+    for (size_t idx = 0; idx < regions.parent.size(); ++idx) {
+        if (regions.find(idx) == idx) {
+            totalPrice += (size_t)regions.area[idx] * regions.corners[idx];
+        }
     }
 
     cout << totalPrice << endl;
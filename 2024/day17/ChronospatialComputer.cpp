@@ -8,12 +8,21 @@
 #include <regex>
 #include <iterator>
 #include <set>
+#include <stack>
+#include <array>
+#include <random>
+#include <chrono>
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
 
 using namespace std;
 using namespace aoc::util::types;
 using namespace aoc::util::graph;
 using namespace aoc::util::math;
 
+#define BENCHMARK 0
+
 const regex REGISTER_RX("Register [ABC]: ([0-9]+)");
 const regex PROGRAM_RX("Program: (.*)");
 
@@ -69,8 +78,8 @@ const string _constructOutputString(const vector<uint64_t> &output) {
     return result;
 }
 
-const uint64_t _comboOperand(const uint64_t operand, const ComputerState &s) {
-    if (operand >= 0 && operand <= 3) {
+uint64_t _comboOperand(const uint64_t operand, const ComputerState &s) {
+    if (operand <= 3) {
         return operand;
     }
 
@@ -95,11 +104,14 @@ const uint64_t _comboOperand(const uint64_t operand, const ComputerState &s) {
     exit(1);
 }
 
+uint64_t _shiftRight(const uint64_t value, const uint64_t shift) {
+    return shift >= 64 ? 0 : value >> shift;
+}
+
 // opcode: 0
 void _adv(const uint64_t operand, ComputerState &s) {
-    const uint64_t numerator = s.registers[RegisterIdx::kA];
-    const uint64_t denominator = 1 << _comboOperand(operand, s);
-    s.registers[RegisterIdx::kA] = numerator / denominator;
+    // numerator / 2^combo
+    s.registers[RegisterIdx::kA] = _shiftRight(s.registers[RegisterIdx::kA], _comboOperand(operand, s));
 
     s.instructionPtr += 2;
 }
@@ -147,23 +159,22 @@ void _out(const uint64_t operand, ComputerState &s) {
 
 // opcode: 6
 void _bdv(const uint64_t operand, ComputerState &s) {
-    const uint64_t numerator = s.registers[RegisterIdx::kA];
-    const uint64_t denominator = 1 << _comboOperand(operand, s);
-    s.registers[RegisterIdx::kB] = numerator / denominator;
+    // numerator / 2^combo
+    s.registers[RegisterIdx::kB] = _shiftRight(s.registers[RegisterIdx::kA], _comboOperand(operand, s));
 
     s.instructionPtr += 2;
 }
 
 // opcode: 7
 void _cdv(const uint64_t operand, ComputerState &s) {
-    const uint64_t numerator = s.registers[RegisterIdx::kA];
-    const uint64_t denominator = 1 << _comboOperand(operand, s);
-    s.registers[RegisterIdx::kC] = numerator / denominator;
+    // numerator / 2^combo
+    s.registers[RegisterIdx::kC] = _shiftRight(s.registers[RegisterIdx::kA], _comboOperand(operand, s));
 
     s.instructionPtr += 2;
 }
 
-void _interpretProgram(ComputerState &s) {
+size_t _interpretProgram(ComputerState &s) {
+    size_t numExecutedInstructions = 0;
     while (!s.isHalted) {
         if (s.instructionPtr >= s.program.size()) {
             s.isHalted = true;
@@ -183,7 +194,214 @@ void _interpretProgram(ComputerState &s) {
             case 7: _cdv(operand, s); break;
             default: cout << "Unknown opcode: " << opcode << endl; exit(1);
         }
+        numExecutedInstructions += 1;
+    }
+
+    return numExecutedInstructions;
+}
+
+// Programs shaped as a single loop (the only jump being a final `jnz 0`) get compiled into their
+// loop body, decoded once: every op has its combo operand already resolved to either a register or
+// a literal, so running an iteration is a single pass over a small flat array with no decoding and
+// no calls. The ops run kLanes register sets side by side, so that candidate register A values can
+// be evaluated in batches (the per-lane loops are left to the compiler to vectorize).
+constexpr size_t kLanes = 8;
+typedef array<uint64_t, kLanes> lanes_t;
+typedef array<vector<uint64_t>, kLanes> lanes_output_t;
+
+struct LaneRegisters {
+    array<lanes_t, RegisterIdx::kCount> registers;
+    array<bool, kLanes> active;
+};
+
+struct CompiledOp {
+    uint8_t opcode;
+    uint8_t target;         // register written by adv / bdv / cdv
+    bool isRegisterCombo;
+    uint8_t comboRegister;
+    lanes_t literal;        // the literal operand (or the combo literal), broadcast to every lane
+};
+
+struct CompiledProgram {
+    bool isCompiled = false;
+    vector<CompiledOp> loopBody;
+};
+
+const CompiledProgram _compileProgram(const vector<size_t> &program) {
+    CompiledProgram compiled;
+
+    if (program.size() < 2 || program.size() % 2 != 0 ||
+        program[program.size() - 2] != 3 || program[program.size() - 1] != 0) {
+        return compiled;
+    }
+
+    for (size_t ip = 0; ip + 2 < program.size(); ip += 2) {
+        const auto opcode = program[ip];
+        const uint64_t operand = program[ip + 1];
+
+        const bool usesCombo = opcode == 0 || opcode == 2 || opcode == 5 || opcode == 6 || opcode == 7;
+        if (opcode == 3 || opcode > 7 || (usesCombo && operand == 7)) {
+            // a jump (or an invalid instruction) in the middle of the loop body
+            return compiled;
+        }
+
+        CompiledOp op = {};
+        op.opcode = opcode;
+        op.target = opcode == 0 ? RegisterIdx::kA : (opcode == 6 ? RegisterIdx::kB : RegisterIdx::kC);
+        op.isRegisterCombo = usesCombo && operand >= 4;
+        op.comboRegister = op.isRegisterCombo ? operand - 4 : 0;
+        op.literal.fill(operand);
+
+        compiled.loopBody.push_back(op);
+    }
+
+    compiled.isCompiled = true;
+    return compiled;
+}
+
+// One iteration of the loop body, for every lane.
+inline void _runLoopBody(const CompiledProgram &compiled, LaneRegisters &r, lanes_output_t &output) {
+    lanes_t &a = r.registers[RegisterIdx::kA];
+    lanes_t &b = r.registers[RegisterIdx::kB];
+    lanes_t &c = r.registers[RegisterIdx::kC];
+
+    for (const auto &op : compiled.loopBody) {
+        const lanes_t &combo = op.isRegisterCombo ? r.registers[op.comboRegister] : op.literal;
+
+        switch (op.opcode) {
+            case 0:
+            case 6:
+            case 7: {
+                // combo may alias the target register, so shift into a copy first
+                lanes_t shifted;
+                for (size_t l = 0; l < kLanes; l++) {
+                    shifted[l] = _shiftRight(a[l], combo[l]);
+                }
+                r.registers[op.target] = shifted;
+                break;
+            }
+            case 1:
+                for (size_t l = 0; l < kLanes; l++) {
+                    b[l] ^= op.literal[l];
+                }
+                break;
+            case 2: {
+                lanes_t value;
+                for (size_t l = 0; l < kLanes; l++) {
+                    value[l] = combo[l] & 7;
+                }
+                b = value;
+                break;
+            }
+            case 4:
+                for (size_t l = 0; l < kLanes; l++) {
+                    b[l] ^= c[l];
+                }
+                break;
+            case 5:
+                for (size_t l = 0; l < kLanes; l++) {
+                    if (r.active[l]) {
+                        output[l].push_back(combo[l] & 7);
+                    }
+                }
+                break;
+        }
+    }
+}
+
+// Runs the compiled loop for kLanes register sets at once; returns the number of executed
+// instructions (summed over the lanes).
+size_t _runCompiled(const CompiledProgram &compiled, LaneRegisters &r, lanes_output_t &output) {
+    size_t numExecutedInstructions = 0;
+    r.active.fill(true);
+
+    while (true) {
+        _runLoopBody(compiled, r, output);
+
+        // jnz 0: lanes whose register A reached 0 fall out of the loop
+        bool anyActive = false;
+        for (size_t l = 0; l < kLanes; l++) {
+            numExecutedInstructions += r.active[l] ? compiled.loopBody.size() + 1 : 0;
+            r.active[l] = r.active[l] && r.registers[RegisterIdx::kA][l] != 0;
+            anyActive |= r.active[l];
+        }
+
+        if (!anyActive) {
+            break;
+        }
+    }
+
+    return numExecutedInstructions;
+}
+
+// Outputs of the program for each of the given register A values (registers B and C start at 0).
+const lanes_output_t _evaluateBatch(const ComputerState &s, const CompiledProgram &compiled, const lanes_t &registerAValues) {
+    lanes_output_t output;
+
+    if (compiled.isCompiled) {
+        LaneRegisters r = {};
+        r.registers[RegisterIdx::kA] = registerAValues;
+        _runCompiled(compiled, r, output);
+        return output;
+    }
+
+    ComputerState laneState = s;
+    for (size_t l = 0; l < kLanes; l++) {
+        laneState.reset();
+        laneState.registers[RegisterIdx::kA] = registerAValues[l];
+        _interpretProgram(laneState);
+        output[l] = laneState.output;
+    }
+
+    return output;
+}
+
+void _benchmark(const ComputerState &s) {
+    const auto compiled = _compileProgram(s.program);
+    if (!compiled.isCompiled) {
+        cout << "Benchmark: program is not a single loop, nothing to compare against" << endl;
+        return;
+    }
+
+    constexpr size_t kNumRuns = 1 << 16;
+    mt19937_64 rng(17);
+    vector<uint64_t> registerAValues(kNumRuns);
+    for (auto &v : registerAValues) {
+        v = rng() >> 16;
+    }
+
+    auto interpreterT1 = high_resolution_clock::now();
+    size_t interpretedInstructions = 0;
+    size_t interpretedChecksum = 0;
+    ComputerState interpreterState = s;
+    for (const auto v : registerAValues) {
+        interpreterState.reset();
+        interpreterState.registers[RegisterIdx::kA] = v;
+        interpretedInstructions += _interpretProgram(interpreterState);
+        interpretedChecksum += interpreterState.output.size();
+    }
+    auto interpreterT2 = high_resolution_clock::now();
+
+    auto compiledT1 = high_resolution_clock::now();
+    size_t compiledInstructions = 0;
+    size_t compiledChecksum = 0;
+    for (size_t i = 0; i < kNumRuns; i += kLanes) {
+        LaneRegisters r = {};
+        copy_n(registerAValues.begin() + i, kLanes, r.registers[RegisterIdx::kA].begin());
+
+        lanes_output_t output;
+        compiledInstructions += _runCompiled(compiled, r, output);
+        for (const auto &laneOutput : output) {
+            compiledChecksum += laneOutput.size();
+        }
     }
+    auto compiledT2 = high_resolution_clock::now();
+
+    const auto interpreterSeconds = duration<double>(interpreterT2 - interpreterT1).count();
+    const auto compiledSeconds = duration<double>(compiledT2 - compiledT1).count();
+    cout << "Benchmark (" << kNumRuns << " runs, outputs " << interpretedChecksum << " / " << compiledChecksum << "):" << endl;
+    cout << "Interpreter: " << interpretedInstructions / interpreterSeconds << " instructions/s" << endl;
+    cout << "Compiled:    " << compiledInstructions / compiledSeconds << " instructions/s" << endl;
 }
 
 void part1(istream& inputFile) {
@@ -233,6 +451,10 @@ void part1(istream& inputFile) {
     cout << endl;
 
     cout << outputStr << endl;
+
+    if (BENCHMARK) {
+        _benchmark(s);
+    }
 }
 
 void part2(istream& inputFile) {
@@ -279,6 +501,8 @@ void part2(istream& inputFile) {
 
     set<uint64_t> validRegisterAValues;
 
+    const auto compiled = _compileProgram(s.program);
+
     stack<RegisterValuesState> registerAValuesToCheck;
     registerAValuesToCheck.push(RegisterValuesState {
         .registerAValue = 0,
@@ -297,38 +521,29 @@ void part2(istream& inputFile) {
             continue;
         }
 
+        // all 8 candidates for the next 3-bit digit are evaluated in one batch
         matchedLastNDigits += 1;
-        for (size_t remainder = 0; remainder < 8; ++remainder) {
-            const uint64_t newRegisterAValue = (registerAValue << 3) + (uint64_t)remainder;
-            // cout << endl << "checking registerA=" << newRegisterAValue << endl;
-
-            s.reset();
-            s.registers[RegisterIdx::kA] = newRegisterAValue;
-            _interpretProgram(s);
+        lanes_t newRegisterAValues;
+        for (size_t remainder = 0; remainder < kLanes; ++remainder) {
+            newRegisterAValues[remainder] = (registerAValue << 3) + (uint64_t)remainder;
+        }
 
-            // const auto outputStr = _constructOutputString(s.output);
-            // cout << outputStr << endl;
+        const auto outputs = _evaluateBatch(s, compiled, newRegisterAValues);
 
-            // check the output for the last `matchedLastNDigits` to see if it matches
-            bool matchedOutputDigits = true;
-            for (size_t digitId = 0; digitId < matchedLastNDigits; ++digitId) {
-                const auto programLastNthDigit = s.program.size() - matchedLastNDigits + digitId;
-                const auto programDigit = s.program[programLastNthDigit];
-                if (s.output[digitId] != programDigit) {
-                    // cout << "s.output[digitId]=" << s.output[digitId] << " != programDigit=" << programDigit << endl;
-                    matchedOutputDigits = false;
-                    break;
-                }
+        for (size_t remainder = 0; remainder < kLanes; ++remainder) {
+            const auto &output = outputs[remainder];
+            if (output.size() < matchedLastNDigits) {
+                continue;
             }
 
+            // check the output for the last `matchedLastNDigits` to see if it matches
+            const bool matchedOutputDigits = equal(output.begin(), output.begin() + matchedLastNDigits, s.program.end() - matchedLastNDigits);
             if (!matchedOutputDigits) {
                 continue;
             }
 
-            // cout << "adding registerA=" << newRegisterAValue << endl;
-
             registerAValuesToCheck.push(RegisterValuesState {
-                .registerAValue = newRegisterAValue,
+                .registerAValue = newRegisterAValues[remainder],
                 .matchedLastNDigits = matchedLastNDigits,
             });
         }
@@ -339,7 +554,11 @@ void part2(istream& inputFile) {
         cout << v << endl;
     }
 
-    const auto minRegisterA = *validRegisterAValues.begin();\
+    if (validRegisterAValues.empty()) {
+        return;
+    }
+
+    const auto minRegisterA = *validRegisterAValues.begin();
     cout << "Minimum registerA value: " << endl;
     cout << minRegisterA << endl;
 }
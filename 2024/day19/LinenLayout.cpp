@@ -3,7 +3,10 @@
 #include "../../util/Types.h"
 #include "../../util/MathUtil.h"
 #include "../../util/Graph.h"
+#include "../../util/Int128.h"
+#include "../../util/Parallel.h"
 
+#include <array>
 #include <vector>
 #include <set>
 #include <queue>
@@ -13,6 +16,8 @@ using namespace aoc::util::string;
 using namespace aoc::util::types;
 using namespace aoc::util::graph;
 using namespace aoc::util::math;
+using namespace aoc::util::int128;
+using namespace aoc::util::parallel;
 
 struct TowelState {
     vector<string> towels;
@@ -34,33 +39,107 @@ void _printState(const TowelState &s) {
     cout << endl;
 }
 
-const uint64_t _countArrangements(const string &pattern, size_t startIdx, const TowelState &s, vector<int64_t> &countCache) {
-    if (startIdx >= pattern.size()) {
-        // we successfully matched the entirety of the pattern
-        return 1;
+// Flat trie over the towel set. Children are stored in a single vector indexed by
+// nodeIdx * alphabetSize + letterIdx, with the alphabet compacted to the letters actually used
+// by the towels, so that 10^5 towels don't blow up into 26-wide nodes.
+struct TowelTrie {
+    static constexpr int32_t kNoChild = -1;
+
+    array<int32_t, 256> letterIdx;
+    size_t alphabetSize = 0;
+    vector<int32_t> children;
+    vector<bool> isTowelEnd;
+
+    TowelTrie(const vector<string> &towels) {
+        letterIdx.fill(kNoChild);
+        for (const auto &towel : towels) {
+            for (const unsigned char ch : towel) {
+                if (letterIdx[ch] == kNoChild) {
+                    letterIdx[ch] = alphabetSize++;
+                }
+            }
+        }
+
+        _addNode();
+        for (const auto &towel : towels) {
+            size_t node = 0;
+            for (const unsigned char ch : towel) {
+                const size_t childSlot = node * alphabetSize + letterIdx[ch];
+                if (children[childSlot] == kNoChild) {
+                    children[childSlot] = _addNode();
+                }
+                node = children[childSlot];
+            }
+            isTowelEnd[node] = true;
+        }
     }
 
-    if (countCache[startIdx] != -1) {
-        return countCache[startIdx];
+private:
+    int32_t _addNode() {
+        children.resize(children.size() + alphabetSize, kNoChild);
+        isTowelEnd.push_back(false);
+        return isTowelEnd.size() - 1;
     }
+};
+
+struct Arrangements {
+    bool isPossible;
+    bool isCountOverflowed;  // there are 2^128 arrangements or more, count is meaningless
+    uint128_t count;
+};
 
-    uint64_t count = 0;
-    for (const auto &towel : s.towels) {
-        if (towel.size() > (pattern.size() - startIdx)) {
-            // current towel is too large for the remaining pattern
+// Forward DP over the pattern positions: ways[i] is the number of arrangements covering the
+// prefix [0, i), and isReachable[i] whether there is any. From every reachable position we walk
+// the trie once along the pattern and push ways[i] forward to the end of every towel met on the way.
+// A prefix whose count does not fit in 128 bits is flagged, and so is every prefix extending it.
+const Arrangements _countArrangements(const string &pattern, const TowelTrie &trie) {
+    vector<uint128_t> ways = vector<uint128_t>(pattern.size() + 1, 0);
+    vector<uint8_t> isReachable = vector<uint8_t>(pattern.size() + 1, false);
+    vector<uint8_t> isOverflowed = vector<uint8_t>(pattern.size() + 1, false);
+    ways[0] = 1;
+    isReachable[0] = true;
+
+    for (size_t startIdx = 0; startIdx < pattern.size(); startIdx++) {
+        if (!isReachable[startIdx]) {
             continue;
         }
 
-        // try to match the current towel with the portion of the pattern that matches its length
-        const string patternSubstr = pattern.substr(startIdx, towel.size());
-        if (patternSubstr == towel) {
-            count += _countArrangements(pattern, startIdx + towel.size(), s, countCache);
+        size_t node = 0;
+        for (size_t i = startIdx; i < pattern.size(); i++) {
+            const auto letter = trie.letterIdx[static_cast<unsigned char>(pattern[i])];
+            if (letter == TowelTrie::kNoChild) {
+                break;
+            }
+
+            const auto child = trie.children[node * trie.alphabetSize + letter];
+            if (child == TowelTrie::kNoChild) {
+                break;
+            }
+
+            node = child;
+            if (trie.isTowelEnd[node]) {
+                isOverflowed[i + 1] |= isOverflowed[startIdx] | __builtin_add_overflow(ways[i + 1], ways[startIdx], &ways[i + 1]);
+                isReachable[i + 1] = true;
+            }
         }
     }
 
-    countCache[startIdx] = count;
+    return Arrangements {
+        .isPossible = static_cast<bool>(isReachable[pattern.size()]),
+        .isCountOverflowed = static_cast<bool>(isOverflowed[pattern.size()]),
+        .count = ways[pattern.size()],
+    };
+}
+
+const vector<Arrangements> _countAllArrangements(const TowelState &s) {
+    const TowelTrie trie(s.towels);
 
-    return count;
+    vector<Arrangements> arrangements = vector<Arrangements>(s.patterns.size());
+    parallelFor(s.patterns.size(), [&](const size_t i) {
+        arrangements[i] = _countArrangements(s.patterns[i], trie);
+    });
+
+    return arrangements;
 }
 
 void part1(istream& inputFile) {
@@ -92,13 +171,8 @@ void part1(istream& inputFile) {
     // _printState(s);
 
     size_t validPatterns = 0;
-    for (const auto &pattern : s.patterns) {
-        vector<int64_t> countCache = vector<int64_t>(pattern.size(), -1);
-        const auto numArrangements = _countArrangements(pattern, 0, s, countCache);
-        validPatterns += numArrangements > 0 ? 1 : 0;
-        // if (numArrangements > 0) {
-        //     cout << pattern << endl;
-        // }
+    for (const auto &arrangements : _countAllArrangements(s)) {
+        validPatterns += arrangements.isPossible ? 1 : 0;
     }
 
     cout << validPatterns << endl;
@@ -132,17 +206,15 @@ void part2(istream& inputFile) {
 
     // _printState(s);
 
-    uint64_t totalArrangements = 0;
-    for (const auto &pattern : s.patterns) {
-        vector<int64_t> countCache = vector<int64_t>(pattern.size(), -1);
-        const auto numArrangements = _countArrangements(pattern, 0, s, countCache);
-        totalArrangements += numArrangements;
-        // if (numArrangements > 0) {
-        //     cout << pattern << endl;
-        // }
+    uint128_t totalArrangements = 0;
+    for (const auto &arrangements : _countAllArrangements(s)) {
+        if (arrangements.isCountOverflowed || __builtin_add_overflow(totalArrangements, arrangements.count, &totalArrangements)) {
+            cout << "The number of arrangements does not fit in 128 bits!" << endl;
+            return;
+        }
     }
 
-    cout << totalArrangements << endl;
+    cout << toString(totalArrangements) << endl;
 }
 
 int main(int argc, char **argv) {
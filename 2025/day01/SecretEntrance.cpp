@@ -1,59 +1,80 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
+#include "../../util/StringUtil.h"
 
-#include <regex>
+#include <iterator>
+#include <vector>
 
 using namespace std;
 
-const regex INSTRUCTION_RX("([L|R])([0-9]+)");
+constexpr int64_t DIAL_SIZE = 100;
+constexpr int64_t DIAL_START = 50;
 
-void part1(istream& inputFile) {
-    short int dial = 50;
-    size_t numZeros = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+struct DialZeros {
+    uint64_t landings = 0;   // rotations ending on 0
+    uint64_t crossings = 0;  // clicks landing on 0, during or at the end of a rotation
+};
+
+// Decodes the "L123" / "R45" lines straight from the buffer into signed deltas.
+const vector<int32_t> parseRotations(istream& inputFile) {
+    const string input((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
 
-        smatch match;
-        if (regex_match(line, match, INSTRUCTION_RX)) {
-            const char direction = match[1].str()[0];
-            const short int distance = stoull(match[2].str());
+    const auto lines = aoc::util::string::splitLines(input);
 
-            const short int sign = direction == 'L' ? -1 : 1;
+    vector<int32_t> deltas;
+    deltas.reserve(lines.size());
 
-            dial = aoc::util::math::positiveModulo(dial + sign * distance, 100);
-            numZeros += dial == 0 ? 1 : 0;
+    for (const auto line : lines) {
+        const char direction = line[0];
+        size_t digitPos = 1;
+        int64_t distance = 0;
+        while (digitPos < line.size() && isdigit(line[digitPos]) && distance <= INT32_MAX) {
+            distance = distance * 10 + (line[digitPos] - '0');
+            digitPos += 1;
         }
+
+        const bool isValid = (direction == 'L' || direction == 'R') && digitPos > 1 &&
+                             digitPos == line.size() && distance <= INT32_MAX;
+        if (!isValid) {
+            cout << "Line { " << line << " } is not a rotation" << endl;
+            continue;
+        }
+
+        deltas.push_back(direction == 'L' ? -distance : distance);
     }
 
-    cout << numZeros << endl;
+    return deltas;
 }
 
-void part2(istream& inputFile) {
-    short int dial = 50;
-    size_t numZeros = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        smatch match;
-        if (regex_match(line, match, INSTRUCTION_RX)) {
-            const char direction = match[1].str()[0];
-            const short int distance = stoull(match[2].str());
-
-            const short int sign = direction == 'L' ? -1 : 1;
-
-            const short int rotations = distance / 100;
-            const short int distanceMod = aoc::util::math::positiveModulo(distance, 100);
-            const short int res = dial + sign * distanceMod;
-            numZeros += ((dial > 0 && res <= 0) || res >= 100) ? rotations + 1 : rotations;
-            dial = aoc::util::math::positiveModulo(res, 100);
-        } else {
-            cout << "Line { " << line << " } did not match regex" << endl;
-        }
+int64_t floorDiv(const int64_t a, const int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// The dial is followed as an unbounded position, the prefix sum of the deltas, so a rotation from
+// p to q passes over 0 once for every multiple of the dial size in (p, q] (right) or [q, p) (left).
+const DialZeros countZeros(const vector<int32_t> &deltas) {
+    DialZeros zeros;
+
+    int64_t position = DIAL_START;
+    for (const int64_t delta : deltas) {
+        const int64_t next = position + delta;
+
+        zeros.landings += aoc::util::math::positiveModulo(next, DIAL_SIZE) == 0;
+        zeros.crossings += delta >= 0 ? floorDiv(next, DIAL_SIZE) - floorDiv(position, DIAL_SIZE)
+                                      : floorDiv(position - 1, DIAL_SIZE) - floorDiv(next - 1, DIAL_SIZE);
+
+        position = next;
     }
 
-    cout << numZeros << endl;
+    return zeros;
+}
+
+void part1(istream& inputFile) {
+    cout << countZeros(parseRotations(inputFile)).landings << endl;
+}
+
+void part2(istream& inputFile) {
+    cout << countZeros(parseRotations(inputFile)).crossings << endl;
 }
 
 int main(int argc, char **argv) {
@@ -78,4 +99,4 @@ int main(int argc, char **argv) {
     inputFile.close();
 
     return 0;
-}
\ No newline at end of file
+}
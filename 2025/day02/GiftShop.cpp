@@ -1,99 +1,103 @@
 #include "../../util/BasicIncludes.h"
+#include "../../util/Int128.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
 
-#include <regex>
+#include <algorithm>
+#include <bit>
+#include <vector>
 
 using namespace std;
+using namespace aoc::util::int128;
 
-bool isInvalidIDPart1(const string& s) {
-    if (s.size() % 2 == 1) {
-        return false;
-    }
+typedef pair<uint64_t, uint64_t> id_range_t;
 
-    const size_t midIdx = s.size() / 2;
-    const size_t startIdx = s.size() % 2 == 0 ? midIdx : midIdx + 1;
+constexpr size_t MAX_DIGITS = 20;  // digits of the largest uint64_t
 
-    for (size_t i = 0; i < midIdx; i++) {
-        const size_t leftIdx = i;
-        const size_t rightIdx = midIdx + i;
-        if (s[leftIdx] != s[rightIdx]) {
-            return false;
-        }
+uint128_t _pow10(const size_t exponent) {
+    uint128_t p = 1;
+    for (size_t i = 0; i < exponent; i++) {
+        p *= 10;
     }
-
-    return true;
+    return p;
 }
 
-bool isInvalidIDPart2(const string& s) {
-    for (size_t i = 1; i < s.size(); i++) {
-        const string substr = s.substr(0, i);
-
-        if (s.size() % substr.size() != 0) {
-            continue;
-        }
+// Sum of the numDigits-long IDs in [lo, hi] made of a blockDigits-long block repeated, i.e.
+// block * 1 0..0 1 0..0 1 (the multiplier is 11, 101, 111, 1001, ...) for every block without a
+// leading zero. Those form an arithmetic progression, so the sum needs no enumeration.
+uint128_t _sumRepeatedBlocks(const uint64_t lo, const uint64_t hi, const size_t numDigits, const size_t blockDigits) {
+    const uint128_t multiplier = (_pow10(numDigits) - 1) / (_pow10(blockDigits) - 1);
 
-        string repeatedSubstr = "";
-        for (size_t j = 0; j < s.size() / substr.size(); j++) {
-            repeatedSubstr += substr;
-        }
-
-        if (repeatedSubstr == s) {
-            return true;
-        }
+    const uint128_t minBlock = max<uint128_t>(_pow10(blockDigits - 1), (lo + multiplier - 1) / multiplier);
+    const uint128_t maxBlock = min<uint128_t>(_pow10(blockDigits) - 1, hi / multiplier);
+    if (minBlock > maxBlock) {
+        return 0;
     }
 
-    return false;
+    const uint128_t numBlocks = maxBlock - minBlock + 1;
+    const uint128_t sumBlocks = (minBlock + maxBlock) * numBlocks / 2;
+    return multiplier * sumBlocks;
 }
 
-// This is SUPER slow
-bool isInvalidIDPart2Regex(const string& s) {
-    const regex REPEATING_PATTERN("^(\\d+)\\1+$");
-
-    smatch match;
-    if (regex_match(s, match, REPEATING_PATTERN)) {
-        return true;
+vector<size_t> _getPrimeFactors(size_t n) {
+    vector<size_t> factors;
+    for (size_t p = 2; p <= n; p++) {
+        if (n % p == 0) {
+            factors.push_back(p);
+            while (n % p == 0) {
+                n /= p;
+            }
+        }
     }
-
-    return false;
+    return factors;
 }
 
-void part1(istream& inputFile) {
-    uint64_t sumInvalidIDs = 0;
-
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        const auto intervals = aoc::util::string::split(line, ',');
-        for (const auto &interval : intervals) {
-            if (interval.empty()) {
-                continue;
+// Sum of the IDs in [lo, hi] made of a block repeated exactly twice (part 1) or at least twice (part 2).
+//
+// An ID that repeats a block of d digits also repeats one of (numDigits / q) digits for some prime q
+// dividing numDigits / d, and an ID repeating blocks of both d and e digits repeats one of gcd(d, e)
+// digits. So the IDs with any repetition are the union over the maximal periods numDigits / q, and
+// inclusion-exclusion over the subsets of those primes counts every ID exactly once.
+uint128_t _sumInvalidIDs(const id_range_t &range, const bool anyRepetition) {
+    uint128_t sum = 0;
+
+    const size_t minDigits = aoc::util::math::getNumberOfDigits(range.first);
+    const size_t maxDigits = aoc::util::math::getNumberOfDigits(range.second);
+    for (size_t numDigits = max<size_t>(minDigits, 2); numDigits <= min(maxDigits, MAX_DIGITS); numDigits++) {
+        // clamp the range to the IDs with exactly numDigits digits
+        const uint64_t lo = max<uint128_t>(range.first, _pow10(numDigits - 1));
+        const uint64_t hi = min<uint128_t>(range.second, _pow10(numDigits) - 1);
+
+        if (!anyRepetition) {
+            if (numDigits % 2 == 0) {
+                sum += _sumRepeatedBlocks(lo, hi, numDigits, numDigits / 2);
             }
-            const auto nums = aoc::util::string::split(interval, '-');
+            continue;
+        }
 
-            // cout << interval << endl;
-            auto currentID = nums[0];
-            const auto endID = nums[1];
-            while (currentID != endID) {
-                if (isInvalidIDPart1(currentID)) {
-                    // cout << currentID << endl;
-                    sumInvalidIDs += stoull(currentID);
+        const auto primes = _getPrimeFactors(numDigits);
+        for (size_t subset = 1; subset < (1ull << primes.size()); subset++) {
+            size_t divisor = 1;
+            for (size_t i = 0; i < primes.size(); i++) {
+                if (subset & (1ull << i)) {
+                    divisor *= primes[i];
                 }
-                currentID = aoc::util::string::incrementStringNumber(currentID);
             }
-            if (isInvalidIDPart1(currentID)) {
-                sumInvalidIDs += stoull(currentID);
+
+            const auto subsetSum = _sumRepeatedBlocks(lo, hi, numDigits, numDigits / divisor);
+            if (popcount(subset) % 2 == 1) {
+                sum += subsetSum;
+            } else {
+                sum -= subsetSum;
             }
-            // cout << endl;
         }
     }
 
-    cout << sumInvalidIDs << endl;
+    return sum;
 }
 
-void part2(istream& inputFile) {
-    uint64_t sumInvalidIDs = 0;
+vector<id_range_t> _readRanges(istream& inputFile) {
+    vector<id_range_t> ranges;
 
     while (!inputFile.eof()) {
         string line;
@@ -105,25 +109,29 @@ void part2(istream& inputFile) {
                 continue;
             }
             const auto nums = aoc::util::string::split(interval, '-');
-
-            // cout << interval << endl;
-            auto currentID = nums[0];
-            const auto endID = nums[1];
-            while (currentID != endID) {
-                if (isInvalidIDPart2(currentID)) {
-                    // cout << currentID << endl;
-                    sumInvalidIDs += stoull(currentID);
-                }
-                currentID = aoc::util::string::incrementStringNumber(currentID);
-            }
-            if (isInvalidIDPart2(currentID)) {
-                sumInvalidIDs += stoull(currentID);
-            }
-            // cout << endl;
+            ranges.emplace_back(stoull(nums[0]), stoull(nums[1]));
         }
     }
 
-    cout << sumInvalidIDs << endl;
+    return ranges;
+}
+
+void part1(istream& inputFile) {
+    uint128_t sumInvalidIDs = 0;
+    for (const auto &range : _readRanges(inputFile)) {
+        sumInvalidIDs += _sumInvalidIDs(range, false);
+    }
+
+    cout << toString(sumInvalidIDs) << endl;
+}
+
+void part2(istream& inputFile) {
+    uint128_t sumInvalidIDs = 0;
+    for (const auto &range : _readRanges(inputFile)) {
+        sumInvalidIDs += _sumInvalidIDs(range, true);
+    }
+
+    cout << toString(sumInvalidIDs) << endl;
 }
 
 int main(int argc, char **argv) {
@@ -3,9 +3,17 @@
 #include "../../util/StringUtil.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <random>
+#include <string_view>
 
 using namespace std;
+using namespace std::chrono;
+
+#define BENCHMARK 0
+
+constexpr size_t MAX_SELECTED_DIGITS = 19;  // the joltage has to fit in a uint64_t
 
 void part1_orig(istream& inputFile) {
     uint64_t totalOutputJoltage = 0;
@@ -38,70 +46,86 @@ void part1_orig(istream& inputFile) {
     cout << totalOutputJoltage << endl;
 }
 
-const size_t maxIndexOfInRange(const vector<unsigned short int> batteries, size_t startIdx, size_t endIdx) {
-    int max = -1;
-    size_t maxIdx = 0;
+// Picks the numDigits-long subsequence of the bank forming the largest number, in one pass: a digit
+// evicts the smaller digits before it as long as enough digits remain to fill the selection. The
+// selection is the stack itself, so it never grows past numDigits.
+uint64_t calculateMaxJoltage(const string_view bank, const size_t numDigits) {
+    if (numDigits > MAX_SELECTED_DIGITS) {
+        cout << "Can not select more than " << MAX_SELECTED_DIGITS << " batteries!" << endl;
+        exit(1);
+    }
+
+    const size_t selectionSize = min(numDigits, bank.size());
+    size_t numDroppable = bank.size() - selectionSize;
 
-    for (size_t i = startIdx; i < endIdx; i++) {
-        if (batteries[i] > max) {
-            maxIdx = i;
-            max = batteries[i];
+    char selection[MAX_SELECTED_DIGITS];
+    size_t numSelected = 0;
+    for (const char battery : bank) {
+        while (numSelected > 0 && numDroppable > 0 && selection[numSelected - 1] < battery) {
+            numSelected -= 1;
+            numDroppable -= 1;
         }
-    }
 
-    return maxIdx;
-}
+        if (numSelected < selectionSize) {
+            selection[numSelected++] = battery;
+        } else {
+            numDroppable -= 1;
+        }
+    }
 
-const uint64_t calculateMaxJoltage(const vector<unsigned short int> batteries, const size_t numDigits) {
     uint64_t currentJoltage = 0;
-
-    int digitIdx = -1;
-    for (int remainingDigits = numDigits - 1; remainingDigits >= 0; remainingDigits--) {
-        digitIdx = maxIndexOfInRange(batteries, digitIdx + 1, batteries.size() - remainingDigits);
-        currentJoltage = currentJoltage * 10 + batteries[digitIdx];
+    for (size_t i = 0; i < numSelected; i++) {
+        currentJoltage = currentJoltage * 10 + (selection[i] - '0');
     }
 
     return currentJoltage;
 }
 
-void part1(istream& inputFile) {
+uint64_t _sumMaxJoltages(istream& inputFile, const size_t numDigits) {
     uint64_t totalOutputJoltage = 0;
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        vector<unsigned short int> batteries;
-        for (const auto &ch : line) {
-            batteries.push_back(ch - '0');
-        }
-
-        const auto currentJoltage = calculateMaxJoltage(batteries, 2);
-        // cout << "currentJoltage= " << currentJoltage << endl << endl;
-        totalOutputJoltage += currentJoltage;
+    string line;
+    while (getline(inputFile, line)) {
+        totalOutputJoltage += calculateMaxJoltage(line, numDigits);
     }
 
-    cout << totalOutputJoltage << endl;
+    return totalOutputJoltage;
 }
 
-void part2(istream& inputFile) {
-    uint64_t totalOutputJoltage = 0;
+void _benchmark() {
+    constexpr size_t kBankSize = 1000000;
+    constexpr size_t kNumRuns = 100;
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+    mt19937 rng(3);
+    string bank(kBankSize, '0');
+    for (auto &battery : bank) {
+        battery = '1' + rng() % 9;
+    }
 
-        vector<unsigned short int> batteries;
-        for (const auto &ch : line) {
-            batteries.push_back(ch - '0');
+    for (const size_t numDigits : {2, 12}) {
+        auto t1 = high_resolution_clock::now();
+        uint64_t checksum = 0;
+        for (size_t run = 0; run < kNumRuns; run++) {
+            checksum += calculateMaxJoltage(bank, numDigits);
         }
+        auto t2 = high_resolution_clock::now();
 
-        const auto currentJoltage = calculateMaxJoltage(batteries, 12);
-        // cout << "currentJoltage= " << currentJoltage << endl << endl;
-        totalOutputJoltage += currentJoltage;
+        const auto seconds = duration<double>(t2 - t1).count();
+        cout << "Benchmark (" << numDigits << " digits, checksum " << checksum << "): "
+             << kBankSize * kNumRuns / seconds << " digits/s" << endl;
     }
+}
 
-    cout << totalOutputJoltage << endl;
+void part1(istream& inputFile) {
+    cout << _sumMaxJoltages(inputFile, 2) << endl;
+}
+
+void part2(istream& inputFile) {
+    cout << _sumMaxJoltages(inputFile, 12) << endl;
+
+    if (BENCHMARK) {
+        _benchmark();
+    }
 }
 
 int main(int argc, char **argv) {
@@ -1,120 +1,123 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
-#include "../../util/Types.h"
 
-#include <set>
+#include <array>
+#include <cstddef>
+#include <vector>
 
 using namespace std;
 
-vector<aoc::util::types::coord_t> getAdjacentRolls(const vector<string>& diagram,
-                                                    const size_t n,
-                                                    const size_t m,
-                                                    aoc::util::types::coord_t position) {
-    vector<aoc::util::types::coord_t> adjacentRolls;
+constexpr uint8_t MAX_ACCESSIBLE_ADJACENT_ROLLS = 3;
 
-    for (short int di = -1; di <= 1; di++) {
-        const short int i = position.first + di;
-        if (i < 0 || i >= n) {
-            continue;
-        }
-        for (short int dj = -1; dj <= 1; dj++) {
-            const short j = position.second + dj;
-            if (j < 0 || j >= m) {
-                continue;
-            }
+// The diagram as a flat grid of 0/1 roll flags, padded with an empty cell on every side so the 8
+// neighbors of any roll are always in bounds.
+struct RollDiagram {
+    size_t width = 0;
+    size_t height = 0;
+    vector<uint8_t> isRoll;
+};
 
-            if (di == 0 && dj == 0) {
-                continue;
-            }
+RollDiagram _readDiagram(istream& inputFile) {
+    vector<string> diagram;
 
-            if (diagram[i][j] == '@') {
-                adjacentRolls.push_back({i, j});
-            }
+    string line;
+    while (getline(inputFile, line)) {
+        if (!line.empty()) {
+            diagram.push_back(line);
         }
     }
 
-    return adjacentRolls;
-}
+    RollDiagram rolls;
+    rolls.height = diagram.size() + 2;
+    rolls.width = (diagram.empty() ? 0 : diagram.front().size()) + 2;
+    rolls.isRoll.assign(rolls.width * rolls.height, 0);
+    for (size_t i = 0; i < diagram.size(); i++) {
+        for (size_t j = 0; j < diagram[i].size() && j + 2 < rolls.width; j++) {
+            rolls.isRoll[(i + 1) * rolls.width + j + 1] = diagram[i][j] == '@';
+        }
+    }
 
-void part1(istream& inputFile) {
-    vector<string> diagram;
+    return rolls;
+}
 
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+// Number of rolls among the 8 neighbors of every cell: the rolls are summed down each column of
+// 3 rows first, then across 3 of those column sums. Both passes are straight loops over flat
+// uint8_t rows, which the compiler vectorizes.
+vector<uint8_t> _countAdjacentRolls(const RollDiagram& rolls) {
+    const size_t w = rolls.width;
+
+    vector<uint8_t> numAdjacent(rolls.isRoll.size(), 0);
+    vector<uint8_t> columnSums(w, 0);
+    for (size_t i = 1; i + 1 < rolls.height; i++) {
+        const uint8_t *above = rolls.isRoll.data() + (i - 1) * w;
+        const uint8_t *row = above + w;
+        const uint8_t *below = row + w;
+        for (size_t j = 0; j < w; j++) {
+            columnSums[j] = above[j] + row[j] + below[j];
+        }
 
-        diagram.push_back(line);
+        uint8_t *counts = numAdjacent.data() + i * w;
+        for (size_t j = 1; j + 1 < w; j++) {
+            counts[j] = columnSums[j - 1] + columnSums[j] + columnSums[j + 1] - row[j];
+        }
     }
 
-    const size_t n = diagram.size();
-    const size_t m = diagram.front().size();
-
-    size_t numAccessibleRolls = 0;
-    set<aoc::util::types::coord_t> accessibleRolls;
-    for (size_t i = 0; i < n; i++) {
-        for (size_t j = 0; j < m; j++) {
-            if (diagram[i][j] != '@') {
-                continue;
-            }
+    return numAdjacent;
+}
 
-            const auto adjacentRolls = getAdjacentRolls(diagram, n, m, {i, j});
+void part1(istream& inputFile) {
+    const auto rolls = _readDiagram(inputFile);
+    const auto numAdjacent = _countAdjacentRolls(rolls);
 
-            if (adjacentRolls.size() < 4) {
-                accessibleRolls.insert({i, j});
-            }
-        }
+    size_t numAccessibleRolls = 0;
+    for (size_t idx = 0; idx < rolls.isRoll.size(); idx++) {
+        numAccessibleRolls += rolls.isRoll[idx] && numAdjacent[idx] <= MAX_ACCESSIBLE_ADJACENT_ROLLS;
     }
 
-    cout << accessibleRolls.size() << endl;
+    cout << numAccessibleRolls << endl;
 }
 
+// Removing a roll can only make its neighbors accessible, so instead of rescanning the diagram in
+// rounds, every removed roll decrements its neighbors' counts and queues the ones that just became
+// accessible. Each roll is queued at most once, for O(cells) total work.
 void part2(istream& inputFile) {
-    vector<string> diagram;
-
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        diagram.push_back(line);
+    auto rolls = _readDiagram(inputFile);
+    auto numAdjacent = _countAdjacentRolls(rolls);
+
+    const ptrdiff_t w = rolls.width;
+    const array<ptrdiff_t, 8> neighborOffsets = {-w - 1, -w, -w + 1, -1, 1, w - 1, w, w + 1};
+
+    // rolls are taken off the diagram as soon as they are queued
+    vector<size_t> worklist;
+    for (size_t idx = 0; idx < rolls.isRoll.size(); idx++) {
+        if (rolls.isRoll[idx] && numAdjacent[idx] <= MAX_ACCESSIBLE_ADJACENT_ROLLS) {
+            rolls.isRoll[idx] = 0;
+            worklist.push_back(idx);
+        }
     }
 
-    const size_t n = diagram.size();
-    const size_t m = diagram.front().size();
+    size_t numRemovedRolls = 0;
+    while (!worklist.empty()) {
+        const size_t idx = worklist.back();
+        worklist.pop_back();
+        numRemovedRolls += 1;
 
-    size_t numAccessibleRolls = 0;
-    set<aoc::util::types::coord_t> totalAccessibleRolls;
-
-    bool hadAccessibleRolls = false;
-    vector<string> updatedDiagram = diagram;
-    do {
-        hadAccessibleRolls = false;
-        set<aoc::util::types::coord_t> accessibleRolls;
-        for (size_t i = 0; i < n; i++) {
-            for (size_t j = 0; j < m; j++) {
-                if (updatedDiagram[i][j] != '@') {
-                    continue;
-                }
-
-                const auto adjacentRolls = getAdjacentRolls(updatedDiagram, n, m, {i, j});
-
-                if (adjacentRolls.size() < 4) {
-                    accessibleRolls.insert({i, j});
-                }
+        for (const auto offset : neighborOffsets) {
+            const size_t neighborIdx = idx + offset;
+            if (!rolls.isRoll[neighborIdx]) {
+                continue;
             }
-        }
 
-        if (accessibleRolls.size()) {
-            hadAccessibleRolls = true;
-            for (const auto &r : accessibleRolls) {
-                updatedDiagram[r.first][r.second] = '.';
+            numAdjacent[neighborIdx] -= 1;
+            if (numAdjacent[neighborIdx] == MAX_ACCESSIBLE_ADJACENT_ROLLS) {
+                rolls.isRoll[neighborIdx] = 0;
+                worklist.push_back(neighborIdx);
             }
-
-            totalAccessibleRolls.insert(accessibleRolls.begin(), accessibleRolls.end());
         }
-    } while (hadAccessibleRolls);
+    }
 
-    cout << totalAccessibleRolls.size() << endl;
+    cout << numRemovedRolls << endl;
 }
 
 int main(int argc, char **argv) {
@@ -1,18 +1,19 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
-#include "../../util/Types.h"
-
-#include <regex>
+#include "../../util/IntervalSet.h"
 
 using namespace std;
+using namespace aoc::util::interval;
 
-const regex INTERVAL_RX("(\\d+)-(\\d+)");
+struct Inventory {
+    vector<interval_t> freshIntervals;
+    vector<uint64_t> ingredientIds;
+};
 
-void part1(istream& inputFile) {
-    vector<aoc::util::types::coord_big_t> freshIntervals;
+Inventory _readInventory(istream& inputFile) {
+    Inventory inventory;
 
-    size_t numFreshIngredients = 0;
     while (!inputFile.eof()) {
         string line;
         getline(inputFile, line);
@@ -21,81 +22,33 @@ void part1(istream& inputFile) {
             continue;
         }
 
-        smatch match;
-        if (regex_match(line, match, INTERVAL_RX)) {
-            const uint64_t first = stoull(match[1].str());
-            const uint64_t second = stoull(match[2].str());
+        // IDs vastly outnumber the intervals, so only the interval lines are split
+        const size_t dashPos = line.find('-');
+        if (dashPos != string::npos) {
+            const uint64_t first = stoull(line.substr(0, dashPos));
+            const uint64_t second = stoull(line.substr(dashPos + 1));
 
-            freshIntervals.push_back({first, second});
+            inventory.freshIntervals.push_back({first, second});
         } else {
-            istringstream iss(line);
-            uint64_t ingredientId;
-            iss >> ingredientId;
-
-            for (const auto &interval : freshIntervals) {
-                if (interval.first <= ingredientId && ingredientId <= interval.second) {
-                    numFreshIngredients += 1;
-                    break;
-                }
-            }
+            inventory.ingredientIds.push_back(stoull(line));
         }
     }
 
-    cout << numFreshIngredients << endl;
-}
-
-bool compareIntervals(aoc::util::types::coord_big_t i1, aoc::util::types::coord_big_t i2) {
-    return i1.first < i2.first;
+    return inventory;
 }
 
-vector<aoc::util::types::coord_big_t> mergeIntervals(const vector<aoc::util::types::coord_big_t>& intervals) {
-    vector<aoc::util::types::coord_big_t> mergedIntervals;
-    vector<aoc::util::types::coord_big_t> sortedIntervals = intervals;
-
-    sort(sortedIntervals.begin(), sortedIntervals.end(), compareIntervals);
-
-    mergedIntervals.push_back(sortedIntervals[0]);
-    for (size_t i = 1; i < sortedIntervals.size(); i++) {
-        auto &prevMergedInterval = mergedIntervals.back();
-        const auto &currentInterval = sortedIntervals[i];
-
-        if (currentInterval.first <= prevMergedInterval.second) {
-            prevMergedInterval.second = max(currentInterval.second, prevMergedInterval.second);
-        } else {
-            mergedIntervals.push_back(currentInterval);
-        }
-    }
+void part1(istream& inputFile) {
+    const auto inventory = _readInventory(inputFile);
+    const IntervalSet freshIds(inventory.freshIntervals);
 
-    return mergedIntervals;
+    cout << freshIds.countContained(inventory.ingredientIds) << endl;
 }
 
 void part2(istream& inputFile) {
-    vector<aoc::util::types::coord_big_t> freshIntervals;
-
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        if (line.empty()) {
-            break;
-        }
-
-        smatch match;
-        if (regex_match(line, match, INTERVAL_RX)) {
-            const uint64_t first = stoull(match[1].str());
-            const uint64_t second = stoull(match[2].str());
-
-            freshIntervals.push_back({first, second});
-        }
-    }
-
-    size_t numFreshIngredientIds = 0;
-    const auto mergedIntervals = mergeIntervals(freshIntervals);
-    for (const auto &interval : mergedIntervals) {
-        numFreshIngredientIds += interval.second - interval.first + 1;
-    }
+    const auto inventory = _readInventory(inputFile);
+    const IntervalSet freshIds(inventory.freshIntervals);
 
-    cout << numFreshIngredientIds << endl;
+    cout << freshIds.size() << endl;
 }
 
 int main(int argc, char **argv) {
@@ -1,122 +1,118 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
-#include "../../util/Types.h"
+
+#include <cctype>
+#include <iterator>
+#include <string_view>
+#include <vector>
 
 using namespace std;
 
-void part1(istream& inputFile) {
-    vector<vector<uint64_t>> problems;
-    vector<char> operators;
-
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-        istringstream iss(line);
-
-        if (line[0] == '+' || line[0] == '*') {
-            char op;
-            while (iss >> op) {
-                operators.push_back(op);
-            }
-        } else {
-            vector<uint64_t> problemNums;
-            size_t number;
-            while (iss >> number) {
-                problemNums.push_back(number);
-            }
+struct WorksheetTotals {
+    uint64_t rowWise = 0;
+    uint64_t columnWise = 0;
+};
 
-            problems.push_back(problemNums);
-        }
+uint64_t applyOperator(const char op, const uint64_t problemTotal, const uint64_t number) {
+    switch (op) {
+        case '+': return problemTotal + number;
+        case '*': return problemTotal * number;
+        default: cout << "Unknown operator= " << op << endl; exit(1);
     }
+}
 
-    uint64_t grandTotal = 0;
-    for (size_t problemId = 0; problemId < problems.front().size(); problemId++) {
-        const auto op = operators[problemId];
-        uint64_t problemTotal = 0;
-        for (size_t numberId = 0; numberId < problems.size(); numberId++) {
-            if (numberId == 0) {
-                problemTotal = problems[numberId][problemId];
-            } else {
-                switch (op) {
-                    case '+': problemTotal += problems[numberId][problemId]; break;
-                    case '*': problemTotal *= problems[numberId][problemId]; break;
-                    default: cout << "Unknown operator= " << op << endl; problemTotal = 0; break;
-                }
-            }
-        }
-        grandTotal += problemTotal;
+// Problems are separated by columns that are blank on every row, so the worksheet is streamed one
+// column at a time and both readings are accumulated on the way: the digits of a column form one
+// cephalopod number, while each row keeps extending its own number until the problem ends.
+const WorksheetTotals evaluateWorksheet(istream& inputFile) {
+    const string worksheet((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
+
+    const vector<string_view> lines = aoc::util::string::splitLines(worksheet);
+
+    WorksheetTotals totals;
+    if (lines.empty()) {
+        return totals;
     }
 
-    cout << grandTotal << endl;
-}
+    // the operator row is the last one
+    const string_view operators = lines.back();
+    const size_t numNumberRows = lines.size() - 1;
 
-void part2(istream& inputFile) {
-    vector<string> numbers;
-    vector<char> operators;
-
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-        istringstream iss(line);
-
-        if (line[0] == '+' || line[0] == '*') {
-            char op;
-            while (iss >> op) {
-                operators.push_back(op);
+    size_t width = 0;
+    for (const auto &line : lines) {
+        width = max(width, line.size());
+    }
+
+    vector<uint64_t> rowNumbers(numNumberRows, 0);
+    vector<uint8_t> rowHasDigits(numNumberRows, 0);
+    char op = 0;
+    bool hasColumnTotal = false;
+    uint64_t columnTotal = 0;
+
+    const auto finishProblem = [&]() {
+        bool hasRowTotal = false;
+        uint64_t rowTotal = 0;
+        for (size_t row = 0; row < numNumberRows; row++) {
+            if (rowHasDigits[row]) {
+                rowTotal = hasRowTotal ? applyOperator(op, rowTotal, rowNumbers[row]) : rowNumbers[row];
+                hasRowTotal = true;
             }
-        } else {
-            numbers.push_back(line);
+            rowNumbers[row] = 0;
+            rowHasDigits[row] = 0;
         }
-    }
 
-    size_t maxColumnSize = 0;
-    for (const auto &numbersLine : numbers) {
-        maxColumnSize = max(maxColumnSize, numbersLine.size());
-    }
+        totals.rowWise += rowTotal;
+        totals.columnWise += columnTotal;
 
-    uint64_t grandTotal = 0;
-    size_t problemIdx = 0;
-    vector<uint64_t> problemNumbers;
-    for (int columnIdx = maxColumnSize - 1; columnIdx >= 0; columnIdx--) {
-        string numberStr;
-        for (size_t digitIdx = 0; digitIdx < numbers.size(); digitIdx++) {
-            if (columnIdx >= numbers[digitIdx].size()) {
+        op = 0;
+        hasColumnTotal = false;
+        columnTotal = 0;
+    };
+
+    for (size_t col = 0; col < width; col++) {
+        bool hasDigits = false;
+        uint64_t columnNumber = 0;
+        for (size_t row = 0; row < numNumberRows; row++) {
+            const string_view line = lines[row];
+            if (col >= line.size() || !isdigit(line[col])) {
                 continue;
             }
 
-            const auto ch = numbers[digitIdx][columnIdx];
-            numberStr.push_back(ch);
+            const int digit = line[col] - '0';
+            columnNumber = columnNumber * 10 + digit;
+            rowNumbers[row] = rowNumbers[row] * 10 + digit;
+            rowHasDigits[row] = 1;
+            hasDigits = true;
         }
 
-        aoc::util::string::trim(numberStr);
-
-        if (!numberStr.empty()) {
-            uint64_t number = stoull(numberStr);
-            problemNumbers.push_back(number);
+        if (hasDigits && !hasColumnTotal) {
+            // the operator does not have to be aligned with the first column of its problem
+            const size_t opCol = operators.find_first_not_of(' ', col);
+            op = opCol == string::npos ? 0 : operators[opCol];
         }
 
-        if (numberStr.empty() || columnIdx == 0) {
-            const auto op = operators[operators.size() - problemIdx - 1];
+        if (hasDigits) {
+            columnTotal = hasColumnTotal ? applyOperator(op, columnTotal, columnNumber) : columnNumber;
+            hasColumnTotal = true;
+        } else if (hasColumnTotal) {
+            finishProblem();
+        }
+    }
 
-            uint64_t problemTotal = problemNumbers.front();
-            for (size_t i = 1; i < problemNumbers.size(); i++) {
-                switch (op) {
-                    case '+': problemTotal += problemNumbers[i]; break;
-                    case '*': problemTotal *= problemNumbers[i]; break;
-                    default: cout << "Unknown operator= " << op << endl; problemTotal = 0; exit(1);
-                }
-            }
+    if (hasColumnTotal) {
+        finishProblem();
+    }
 
-            grandTotal += problemTotal;
+    return totals;
+}
 
-            // reset everything
-            problemNumbers.clear();
-            problemIdx += 1;
-        }
-    }
+void part1(istream& inputFile) {
+    cout << evaluateWorksheet(inputFile).rowWise << endl;
+}
 
-    cout << grandTotal << endl;
+void part2(istream& inputFile) {
+    cout << evaluateWorksheet(inputFile).columnWise << endl;
 }
 
 int main(int argc, char **argv) {
@@ -1,148 +1,84 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
-#include "../../util/Types.h"
 
-#include <queue>
-#include <set>
+#include <vector>
 
 using namespace std;
 
-const bool isSplitter(const vector<string> &tachyonMap, const aoc::util::types::coord_t pos) {
-    return tachyonMap[pos.first][pos.second] == '^';
-}
-
-const uint64_t traverseTachyon(const vector<string> &tachyonMap, const aoc::util::types::coord_t startPosition) {
-    const auto n = tachyonMap.size();
-    const auto m = tachyonMap.front().size();
+struct TachyonSweep {
+    uint64_t numSplittersHit = 0;
+    uint64_t numTimelines = 0;
+};
 
-    queue<aoc::util::types::coord_t> positionsToVisit;
-    positionsToVisit.push(startPosition);
+// Streams the manifold row by row, keeping only the number of timelines with a beam in each column
+// of the current row: a column has a beam iff its count is non-zero. Beams only ever move one row
+// down, so a splitter just hands the count above it to its two neighbors in the same row.
+const TachyonSweep sweepTachyon(istream& inputFile) {
+    TachyonSweep sweep;
 
-    size_t numSplittersHit = 0;
-    set<aoc::util::types::coord_t> visitedPositions;
-    while (!positionsToVisit.empty()) {
-        const auto &pos = positionsToVisit.front();
-        positionsToVisit.pop();
+    vector<uint64_t> timelines;
+    vector<uint64_t> nextTimelines;
+    vector<size_t> splitterColumns;
 
-        if (visitedPositions.contains(pos)) {
+    string line;
+    while (getline(inputFile, line)) {
+        if (line.empty()) {
             continue;
         }
 
-        visitedPositions.insert(pos);
-        if (pos.first == n - 1) {
-            continue;
+        if (timelines.empty()) {
+            timelines.assign(line.size(), 0);
+        } else if (line.size() != timelines.size()) {
+            cout << "Rows of the manifold must have the same width!" << endl;
+            exit(1);
         }
 
-        aoc::util::types::coord_t newPosition = {pos.first + 1, pos.second};
-        if (isSplitter(tachyonMap, newPosition)) {
-            numSplittersHit += 1;
-
-            if (newPosition.second > 0) {
-                positionsToVisit.push({newPosition.first, newPosition.second - 1});
-            }
-
-            if (newPosition.second < m - 1) {
-                positionsToVisit.push({newPosition.first, newPosition.second + 1});
-            }
-        } else {
-            positionsToVisit.push(newPosition);
+        splitterColumns.clear();
+        for (size_t col = line.find('^'); col != string::npos; col = line.find('^', col + 1)) {
+            splitterColumns.push_back(col);
         }
-    }
-
-    return numSplittersHit;
-}
-
-const uint64_t traverseTachyonTimelines(const vector<string> &tachyonMap, const aoc::util::types::coord_t startPosition) {
-    const auto n = tachyonMap.size();
-    const auto m = tachyonMap.front().size();
 
-    vector<vector<uint64_t>> timelineVisits(n, vector<uint64_t>(m, 0));
-    queue<aoc::util::types::coord_t> positionsToVisit;
-    positionsToVisit.push(startPosition);
-    timelineVisits[startPosition.first][startPosition.second] += 1;
-
-    set<aoc::util::types::coord_t> visitedPositions;
-    while (!positionsToVisit.empty()) {
-        const auto &pos = positionsToVisit.front();
-        positionsToVisit.pop();
-
-        if (visitedPositions.contains(pos)) {
-            continue;
+        // all the beams go straight down, except the ones hitting a splitter
+        nextTimelines = timelines;
+        for (const auto col : splitterColumns) {
+            nextTimelines[col] = 0;
         }
-
-        visitedPositions.insert(pos);
-        if (pos.first == n - 1) {
-            continue;
-        }
-
-        aoc::util::types::coord_t newPosition = {pos.first + 1, pos.second};
-        if (isSplitter(tachyonMap, newPosition)) {
-            if (newPosition.second > 0) {
-                positionsToVisit.push({newPosition.first, newPosition.second - 1});
-                timelineVisits[newPosition.first][newPosition.second - 1] += timelineVisits[pos.first][pos.second];
+        for (const auto col : splitterColumns) {
+            const auto numArriving = timelines[col];
+            if (numArriving == 0) {
+                continue;
             }
 
-            if (newPosition.second < m - 1) {
-                positionsToVisit.push({newPosition.first, newPosition.second + 1});
-                timelineVisits[newPosition.first][newPosition.second + 1] += timelineVisits[pos.first][pos.second];
+            sweep.numSplittersHit += 1;
+            if (col > 0) {
+                nextTimelines[col - 1] += numArriving;
+            }
+            if (col + 1 < nextTimelines.size()) {
+                nextTimelines[col + 1] += numArriving;
             }
-        } else {
-            positionsToVisit.push(newPosition);
-            timelineVisits[newPosition.first][newPosition.second] += timelineVisits[pos.first][pos.second];
+        }
+        swap(timelines, nextTimelines);
+
+        const size_t startCol = line.find('S');
+        if (startCol != string::npos) {
+            timelines[startCol] += 1;
         }
     }
 
-    uint64_t numTimelines = 0;
-    for (size_t i = 0; i < m; i++) {
-        numTimelines += timelineVisits[n - 1][i];
+    for (const auto numArriving : timelines) {
+        sweep.numTimelines += numArriving;
     }
 
-    return numTimelines;
+    return sweep;
 }
 
 void part1(istream& inputFile) {
-    vector<string> tachyonMap;
-    size_t i = 0;
-    aoc::util::types::coord_t startPos;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        size_t j = line.find('S');
-        if (j != std::string::npos) {
-            startPos.first = i;
-            startPos.second = j;
-        }
-
-        tachyonMap.push_back(line);
-        i += 1;
-    }
-
-    const auto beamSplits = traverseTachyon(tachyonMap, startPos);
-    cout << beamSplits << endl;
+    cout << sweepTachyon(inputFile).numSplittersHit << endl;
 }
 
 void part2(istream& inputFile) {
-    vector<string> tachyonMap;
-    size_t i = 0;
-    aoc::util::types::coord_t startPos;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        size_t j = line.find('S');
-        if (j != std::string::npos) {
-            startPos.first = i;
-            startPos.second = j;
-        }
-
-        tachyonMap.push_back(line);
-        i += 1;
-    }
-
-    const auto numTimelines = traverseTachyonTimelines(tachyonMap, startPos);
-    cout << numTimelines << endl;
+    cout << sweepTachyon(inputFile).numTimelines << endl;
 }
 
 int main(int argc, char **argv) {
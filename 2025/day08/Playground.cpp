@@ -3,10 +3,12 @@
 #include "../../util/StringUtil.h"
 #include "../../util/Types.h"
 
-#include <queue>
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <map>
-#include <set>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
 
 using namespace std;
 using namespace aoc::util::types;
@@ -16,136 +18,242 @@ struct JunctionBox {
     size_t idx;
 };
 
-struct JunctionBoxDistance {
-    size_t value;
-    JunctionBox boxA;
-    JunctionBox boxB;
-};
+struct Connection {
+    uint64_t distanceSq;
+    uint32_t boxA;
+    uint32_t boxB;
 
-struct CompareJunctionBoxDistance {
-    bool operator()(const JunctionBoxDistance& distanceA, const JunctionBoxDistance &distanceB) {
-        return distanceA.value > distanceB.value;
+    bool operator<(const Connection &other) const {
+        return tie(distanceSq, boxA, boxB) < tie(other.distanceSq, other.boxA, other.boxB);
     }
 };
 
-struct CompareCircuits {
-    bool operator()(const set<size_t> &circuitA, const set<size_t> &circuitB) {
-        return circuitA.size() < circuitB.size();
+// Union-find over the boxes, merging the smaller circuit into the larger one.
+struct Circuits {
+    vector<uint32_t> parent;
+    vector<uint32_t> size;
+    size_t numCircuits = 0;
+
+    Circuits(const size_t numBoxes) : parent(numBoxes), size(numBoxes, 1), numCircuits(numBoxes) {
+        iota(parent.begin(), parent.end(), 0);
+    }
+
+    uint32_t find(uint32_t idx) {
+        while (parent[idx] != idx) {
+            parent[idx] = parent[parent[idx]];
+            idx = parent[idx];
+        }
+        return idx;
+    }
+
+    bool unite(const uint32_t a, const uint32_t b) {
+        auto rootA = find(a);
+        auto rootB = find(b);
+        if (rootA == rootB) {
+            return false;
+        }
+
+        if (size[rootA] < size[rootB]) {
+            swap(rootA, rootB);
+        }
+        parent[rootB] = rootA;
+        size[rootA] += size[rootB];
+        numCircuits -= 1;
+
+        return true;
     }
 };
 
-const uint64_t calculateDistance(const JunctionBox &boxA, const JunctionBox &boxB) {
-    return sqrt(pow(int(boxA.position.x) - int(boxB.position.x), 2) +
-                pow(int(boxA.position.y) - int(boxB.position.y), 2) +
-                pow(int(boxA.position.z) - int(boxB.position.z), 2));
+uint64_t calculateDistanceSq(const JunctionBox &boxA, const JunctionBox &boxB) {
+    const int64_t dx = int64_t(boxA.position.x) - int64_t(boxB.position.x);
+    const int64_t dy = int64_t(boxA.position.y) - int64_t(boxB.position.y);
+    const int64_t dz = int64_t(boxA.position.z) - int64_t(boxB.position.z);
+    return dx * dx + dy * dy + dz * dz;
 }
 
-const vector<set<size_t>> generateCircuits(const vector<JunctionBox> &boxes, const size_t kNumConnections = 1000) {
-    priority_queue<JunctionBoxDistance, vector<JunctionBoxDistance>, CompareJunctionBoxDistance> distancesPQ;
-    for (size_t i = 0; i < boxes.size() - 1; i++) {
-        for (size_t j = i + 1; j < boxes.size(); j++) {
-            const auto d = calculateDistance(boxes[i], boxes[j]);
-            distancesPQ.push(JunctionBoxDistance(d, boxes[i], boxes[j]));
-        }
+struct BoundingBox {
+    coord3d_t min;
+    coord3d_t max;
+
+    double diagonal() const {
+        return sqrt(pow(double(max.x - min.x), 2) + pow(double(max.y - min.y), 2) + pow(double(max.z - min.z), 2));
     }
 
-    map<size_t, size_t> boxIdxToCircuitIdx;
-    map<size_t, set<size_t>> circuits;
-    for (const auto &box : boxes) {
-        boxIdxToCircuitIdx[box.idx] = box.idx;
-        circuits[box.idx] = {box.idx};
+    double volume() const {
+        return double(max.x - min.x + 1) * double(max.y - min.y + 1) * double(max.z - min.z + 1);
     }
+};
 
-    size_t connectionIdx = 0;
-    while (connectionIdx < kNumConnections && !distancesPQ.empty()) {
-        const auto boxDistance = distancesPQ.top();
-        distancesPQ.pop();
+const BoundingBox getBoundingBox(const vector<JunctionBox> &boxes) {
+    BoundingBox bounds = {boxes.front().position, boxes.front().position};
+    for (const auto &box : boxes) {
+        bounds.min = {min(bounds.min.x, box.position.x), min(bounds.min.y, box.position.y), min(bounds.min.z, box.position.z)};
+        bounds.max = {max(bounds.max.x, box.position.x), max(bounds.max.y, box.position.y), max(bounds.max.z, box.position.z)};
+    }
+    return bounds;
+}
 
-        connectionIdx += 1;
+// Radius within which numPairs pairs are expected if the boxes were spread uniformly.
+double estimateRadius(const vector<JunctionBox> &boxes, const BoundingBox &bounds, const size_t numPairs) {
+    const double n = boxes.size();
+    return cbrt(3.0 * bounds.volume() * numPairs / (2.0 * M_PI * n * n));
+}
 
-        const auto boxAIdx = boxDistance.boxA.idx;
-        const auto boxBIdx = boxDistance.boxB.idx;
+// Every connection with minDistanceSq <= distance^2 <= maxDistanceSq. The boxes are bucketed in a
+// grid of cubes as wide as the max distance, so only the boxes in the same or a neighboring cube
+// need to be compared.
+const vector<Connection> findConnectionsWithin(const vector<JunctionBox> &boxes,
+                                               const BoundingBox &bounds,
+                                               const uint64_t minDistanceSq,
+                                               const uint64_t maxDistanceSq) {
+    const uint64_t cellSize = max<uint64_t>(1, ceil(sqrt(double(maxDistanceSq))));
+    const uint64_t ny = (bounds.max.y - bounds.min.y) / cellSize + 1;
+    const uint64_t nz = (bounds.max.z - bounds.min.z) / cellSize + 1;
+
+    const auto cellOf = [&](const JunctionBox &box) -> array<int64_t, 3> {
+        return {int64_t((box.position.x - bounds.min.x) / cellSize),
+                int64_t((box.position.y - bounds.min.y) / cellSize),
+                int64_t((box.position.z - bounds.min.z) / cellSize)};
+    };
+    const auto cellKey = [&](const array<int64_t, 3> &cell) -> uint64_t {
+        return (cell[0] * ny + cell[1]) * nz + cell[2];
+    };
+
+    // boxes sorted by cell, each cell being a contiguous range of them
+    vector<uint32_t> boxesByCell(boxes.size());
+    iota(boxesByCell.begin(), boxesByCell.end(), 0);
+    vector<uint64_t> keys(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        keys[i] = cellKey(cellOf(boxes[i]));
+    }
+    sort(boxesByCell.begin(), boxesByCell.end(), [&](const uint32_t a, const uint32_t b) {
+        return keys[a] < keys[b];
+    });
+
+    unordered_map<uint64_t, pair<size_t, size_t>> cellRanges;
+    for (size_t start = 0; start < boxesByCell.size();) {
+        size_t end = start + 1;
+        while (end < boxesByCell.size() && keys[boxesByCell[end]] == keys[boxesByCell[start]]) {
+            end += 1;
+        }
+        cellRanges[keys[boxesByCell[start]]] = {start, end};
+        start = end;
+    }
 
-        if (boxIdxToCircuitIdx.contains(boxAIdx) &&
-            boxIdxToCircuitIdx.contains(boxBIdx) &&
-            boxIdxToCircuitIdx[boxAIdx] == boxIdxToCircuitIdx[boxBIdx]) {
-                continue;
+    vector<Connection> connections;
+    const auto addIfWithin = [&](const uint32_t a, const uint32_t b) {
+        const auto distanceSq = calculateDistanceSq(boxes[a], boxes[b]);
+        if (distanceSq >= minDistanceSq && distanceSq <= maxDistanceSq) {
+            connections.push_back({distanceSq, min(a, b), max(a, b)});
         }
+    };
 
-        // merge circuits
-        if (boxIdxToCircuitIdx.contains(boxAIdx) &&
-            boxIdxToCircuitIdx.contains(boxBIdx) &&
-            boxIdxToCircuitIdx[boxAIdx] != boxIdxToCircuitIdx[boxBIdx]) {
-                const auto circuitIdxToRemove = boxIdxToCircuitIdx[boxBIdx];
-                const auto circuitIdxToSave = boxIdxToCircuitIdx[boxAIdx];
+    for (const auto &[key, range] : cellRanges) {
+        const auto cell = cellOf(boxes[boxesByCell[range.first]]);
 
-                for (const auto boxIdx : circuits[circuitIdxToRemove]) {
-                    boxIdxToCircuitIdx[boxIdx] = circuitIdxToSave;
-                    circuits[circuitIdxToSave].insert(boxIdx);
+        for (size_t i = range.first; i < range.second; i++) {
+            for (size_t j = i + 1; j < range.second; j++) {
+                addIfWithin(boxesByCell[i], boxesByCell[j]);
+            }
+        }
+
+        // every pair of neighboring cells is visited once, from the cell with the smaller offset
+        for (int64_t dx = -1; dx <= 1; dx++) {
+            for (int64_t dy = -1; dy <= 1; dy++) {
+                for (int64_t dz = -1; dz <= 1; dz++) {
+                    const bool isForward = dx > 0 || (dx == 0 && (dy > 0 || (dy == 0 && dz > 0)));
+                    const array<int64_t, 3> neighbor = {cell[0] + dx, cell[1] + dy, cell[2] + dz};
+                    if (!isForward || neighbor[0] < 0 || neighbor[1] < 0 || neighbor[2] < 0 ||
+                        neighbor[1] >= int64_t(ny) || neighbor[2] >= int64_t(nz)) {
+                        continue;
+                    }
+
+                    const auto it = cellRanges.find(cellKey(neighbor));
+                    if (it == cellRanges.end()) {
+                        continue;
+                    }
+
+                    for (size_t i = range.first; i < range.second; i++) {
+                        for (size_t j = it->second.first; j < it->second.second; j++) {
+                            addIfWithin(boxesByCell[i], boxesByCell[j]);
+                        }
+                    }
                 }
+            }
+        }
+    }
 
-                circuits.erase(circuitIdxToRemove);
+    return connections;
+}
 
-                continue;
+// The numConnections shortest connections, in order. The search radius grows until it holds enough
+// pairs (at worst all of them), then only those are partially sorted.
+const vector<Connection> findShortestConnections(const vector<JunctionBox> &boxes, const size_t numConnections) {
+    const auto bounds = getBoundingBox(boxes);
+    const uint64_t numPairs = boxes.size() * (boxes.size() - 1) / 2;
+    const size_t numWanted = min<uint64_t>(numConnections, numPairs);
+
+    double radius = max(1.0, estimateRadius(boxes, bounds, numWanted));
+    while (true) {
+        const uint64_t maxDistanceSq = radius >= bounds.diagonal() ? UINT64_MAX : uint64_t(radius * radius);
+        auto connections = findConnectionsWithin(boxes, bounds, 0, maxDistanceSq);
+        if (connections.size() >= numWanted || maxDistanceSq == UINT64_MAX) {
+            nth_element(connections.begin(), connections.begin() + numWanted, connections.end());
+            connections.resize(numWanted);
+            sort(connections.begin(), connections.end());
+            return connections;
         }
-    }
 
-    vector<set<size_t>> circuitsVector;
-    for (const auto &p : circuits) {
-        circuitsVector.push_back(p.second);
+        radius *= 2;
     }
-
-    return circuitsVector;
 }
 
-const pair<size_t, size_t> getLastConnectedPair(const vector<JunctionBox> &boxes) {
-    priority_queue<JunctionBoxDistance, vector<JunctionBoxDistance>, CompareJunctionBoxDistance> distancesPQ;
-    for (size_t i = 0; i < boxes.size() - 1; i++) {
-        for (size_t j = i + 1; j < boxes.size(); j++) {
-            const auto d = calculateDistance(boxes[i], boxes[j]);
-            distancesPQ.push(JunctionBoxDistance(d, boxes[i], boxes[j]));
-        }
+// Circuit sizes after making the numConnections shortest connections.
+const vector<size_t> generateCircuits(const vector<JunctionBox> &boxes, const size_t kNumConnections = 1000) {
+    Circuits circuits(boxes.size());
+    for (const auto &connection : findShortestConnections(boxes, kNumConnections)) {
+        circuits.unite(connection.boxA, connection.boxB);
     }
 
-    map<size_t, size_t> boxIdxToCircuitIdx;
-    map<size_t, set<size_t>> circuits;
-    for (const auto &box : boxes) {
-        boxIdxToCircuitIdx[box.idx] = box.idx;
-        circuits[box.idx] = {box.idx};
+    vector<size_t> circuitSizes;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (circuits.find(i) == i) {
+            circuitSizes.push_back(circuits.size[i]);
+        }
     }
 
-    pair<size_t, size_t> lastConnectedBoxes;
-    while (!distancesPQ.empty() && circuits.size() != 1) {
-        const auto boxDistance = distancesPQ.top();
-        distancesPQ.pop();
+    return circuitSizes;
+}
 
-        const auto boxAIdx = boxDistance.boxA.idx;
-        const auto boxBIdx = boxDistance.boxB.idx;
+// Kruskal over shells of growing radius: all the connections of a shell are longer than the ones
+// of the previous shells, so sorting each shell on its own keeps the global order. Most inputs
+// connect long before the radius covers all the pairs.
+const pair<size_t, size_t> getLastConnectedPair(const vector<JunctionBox> &boxes) {
+    const auto bounds = getBoundingBox(boxes);
 
-        lastConnectedBoxes = {boxAIdx, boxBIdx};
+    Circuits circuits(boxes.size());
+    pair<size_t, size_t> lastConnectedBoxes = {0, 0};
 
-        if (boxIdxToCircuitIdx.contains(boxAIdx) &&
-            boxIdxToCircuitIdx.contains(boxBIdx) &&
-            boxIdxToCircuitIdx[boxAIdx] == boxIdxToCircuitIdx[boxBIdx]) {
-                continue;
-        }
+    uint64_t minDistanceSq = 0;
+    double radius = max(1.0, estimateRadius(boxes, bounds, 4 * boxes.size()));
+    while (circuits.numCircuits > 1) {
+        const uint64_t maxDistanceSq = radius >= bounds.diagonal() ? UINT64_MAX : uint64_t(radius * radius);
 
-        // merge circuits
-        if (boxIdxToCircuitIdx.contains(boxAIdx) &&
-            boxIdxToCircuitIdx.contains(boxBIdx) &&
-            boxIdxToCircuitIdx[boxAIdx] != boxIdxToCircuitIdx[boxBIdx]) {
-                const auto circuitIdxToRemove = boxIdxToCircuitIdx[boxBIdx];
-                const auto circuitIdxToSave = boxIdxToCircuitIdx[boxAIdx];
+        auto connections = findConnectionsWithin(boxes, bounds, minDistanceSq, maxDistanceSq);
+        sort(connections.begin(), connections.end());
 
-                for (const auto boxIdx : circuits[circuitIdxToRemove]) {
-                    boxIdxToCircuitIdx[boxIdx] = circuitIdxToSave;
-                    circuits[circuitIdxToSave].insert(boxIdx);
+        for (const auto &connection : connections) {
+            if (circuits.unite(connection.boxA, connection.boxB)) {
+                lastConnectedBoxes = {connection.boxA, connection.boxB};
+                if (circuits.numCircuits == 1) {
+                    break;
                 }
-
-                circuits.erase(circuitIdxToRemove);
-
-                continue;
+            }
         }
+
+        // once the shell reached UINT64_MAX every pair was tried, so the loop is over either way
+        minDistanceSq = maxDistanceSq + 1;
+        radius *= 2;
     }
 
     return lastConnectedBoxes;
@@ -164,32 +272,13 @@ void part1(istream& inputFile) {
         i += 1;
     }
 
-    const auto circuitsVector = generateCircuits(boxes);
-
-    // cout << "num circuits= " << circuitsVector.size() << endl;
-    // for (const auto &circuit : circuitsVector) {
-    //     cout << "circuit (" << circuit.size() << ")= { ";
-    //     for (const auto boxIdx : circuit) {
-    //         cout << "[ " << boxes[boxIdx].position.x << " " << boxes[boxIdx].position.y << " " << boxes[boxIdx].position.z << " ] ";
-    //     }
-    //     cout << "}" << endl;
-    // }
-
-    priority_queue<set<size_t>, vector<set<size_t>>, CompareCircuits> circuitsPQ;
-    for (const auto &circuit : circuitsVector) {
-        circuitsPQ.push(circuit);
-    }
+    auto circuitSizes = generateCircuits(boxes);
+    const size_t kNumCircuits = min<size_t>(3, circuitSizes.size());
+    partial_sort(circuitSizes.begin(), circuitSizes.begin() + kNumCircuits, circuitSizes.end(), greater<>());
 
     uint64_t largestCircuitsSize = 1;
-    const size_t kNumCircuits = 3;
-    size_t circuitPopIdx = 0;
-    while (circuitPopIdx < kNumCircuits && !circuitsPQ.empty()) {
-        const auto circuit = circuitsPQ.top();
-        circuitsPQ.pop();
-
-        largestCircuitsSize *= circuit.size();
-
-        circuitPopIdx += 1;
+    for (size_t i = 0; i < kNumCircuits; i++) {
+        largestCircuitsSize *= circuitSizes[i];
     }
 
     cout << largestCircuitsSize << endl;
@@ -2,23 +2,21 @@
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
 #include "../../util/Types.h"
+#include "../../util/Parallel.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
+#include <memory>
+#include <tuple>
 
 using namespace std;
+using namespace aoc::util::parallel;
 using namespace aoc::util::types;
 
 
-struct Edge {
-    coord_big_t pointA;
-    coord_big_t pointB;
-
-    const bool isVertical() const {
-        return pointA.first == pointB.first;
-    }
-};
-
 const uint64_t getRectangleArea(const coord_t &squareA, const coord_t &squareB) {
     return (abs(int64_t(squareA.first) - int64_t(squareB.first)) + 1) *
             (abs(int64_t(squareA.second) - int64_t(squareB.second)) + 1);
@@ -44,6 +42,214 @@ void part1(istream& inputFile) {
     cout << largestArea << endl;
 }
 
+// Sweep of the compressed grid (see CompressedPolygon) along one axis, built from the polygon's
+// edges perpendicular to that axis, each given as (column, fromRow, toRow) when sweeping the rows.
+// Every edge changes the winding number by one across its column: the rows strictly between two
+// coordinates count the change twice, as do the rows on a coordinate the edge passes through, and
+// the rows of its endpoints once, which they share with the row on the other side. The winding
+// number being 1 inside, a row has a positive prefix sum over the column gaps exactly where it is
+// inside the polygon or on its boundary.
+//
+// The sweep is a persistent segment tree over the column gaps with one version per row, so it takes
+// O(#edges * log(#columns)) memory and a row range is checked in O(log(#columns)).
+class WindingSweep {
+public:
+    typedef array<size_t, 3> edge_t;  // column, fromRow, toRow
+
+    WindingSweep(const vector<edge_t> &edges, const size_t numRows, const size_t numColumns)
+        : _numGaps(numColumns / 2 + 1), _nodes(1), _roots(numRows, 0) {
+        if (edges.empty()) {
+            return;
+        }
+
+        // the first edge of every row is entered from the outside, so the leftmost edge of all
+        // gives the direction that counts as +1
+        const auto &leftmost = *min_element(edges.begin(), edges.end());
+        const bool isPositiveUp = leftmost[1] < leftmost[2];
+
+        // (row, gap, change), the gap being the one right of the edge
+        vector<tuple<size_t, size_t, int16_t>> changes;
+        for (const auto &[column, fromRow, toRow] : edges) {
+            const int16_t change = (fromRow < toRow) == isPositiveUp ? 1 : -1;
+            const size_t gap = column / 2 + 1;
+            const size_t minRow = min(fromRow, toRow);
+            const size_t maxRow = max(fromRow, toRow);
+            changes.push_back({minRow, gap, change});
+            changes.push_back({minRow + 1, gap, change});
+            changes.push_back({maxRow, gap, int16_t(-change)});
+            changes.push_back({maxRow + 1, gap, int16_t(-change)});
+        }
+        sort(changes.begin(), changes.end());
+
+        int32_t root = 0;
+        size_t changeIdx = 0;
+        for (size_t row = 0; row < numRows; row++) {
+            // nodes created for this row are not shared yet, so further changes update them in place
+            const int32_t firstRowNode = _nodes.size();
+            while (changeIdx < changes.size() && get<0>(changes[changeIdx]) == row) {
+                const auto [_, gap, change] = changes[changeIdx];
+                root = _add(root, 0, _numGaps - 1, gap, change, firstRowNode);
+                changeIdx += 1;
+            }
+            _roots[row] = root;
+        }
+    }
+
+    // Whether the row is inside the polygon, or on its boundary, over all the gaps strictly between
+    // the two columns.
+    bool isCovered(const size_t row, const size_t minColumn, const size_t maxColumn) const {
+        int32_t prefix = 0;
+        int32_t minPrefix = INT32_MAX;
+        _minPrefix(_roots[row], 0, _numGaps - 1, minColumn / 2 + 1, (maxColumn - 1) / 2, prefix, minPrefix);
+        return minPrefix > 0;
+    }
+
+private:
+    // node 0 is the tree with no changes at all, its children being itself
+    struct Node {
+        int32_t left = 0;
+        int32_t right = 0;
+        int16_t sum = 0;
+        int16_t minPrefix = 0;  // over the non-empty prefixes of the node's gaps
+    };
+
+    int32_t _add(const int32_t node, const size_t lo, const size_t hi, const size_t gap, const int16_t change, const int32_t firstRowNode) {
+        int32_t current = node;
+        if (current < firstRowNode) {
+            _nodes.push_back(_nodes[node]);
+            current = _nodes.size() - 1;
+        }
+
+        if (lo == hi) {
+            _nodes[current].sum += change;
+            _nodes[current].minPrefix = _nodes[current].sum;
+            return current;
+        }
+
+        const size_t mid = lo + (hi - lo) / 2;
+        if (gap <= mid) {
+            const int32_t left = _add(_nodes[current].left, lo, mid, gap, change, firstRowNode);
+            _nodes[current].left = left;
+        } else {
+            const int32_t right = _add(_nodes[current].right, mid + 1, hi, gap, change, firstRowNode);
+            _nodes[current].right = right;
+        }
+
+        const auto &left = _nodes[_nodes[current].left];
+        const auto &right = _nodes[_nodes[current].right];
+        _nodes[current].sum = left.sum + right.sum;
+        _nodes[current].minPrefix = min<int16_t>(left.minPrefix, left.sum + right.minPrefix);
+        return current;
+    }
+
+    // prefix accumulates the sum of the gaps before the visited node
+    void _minPrefix(const int32_t node, const size_t lo, const size_t hi, const size_t l, const size_t r, int32_t &prefix, int32_t &minPrefix) const {
+        if (lo > r) {
+            return;
+        }
+        if (hi < l) {
+            prefix += _nodes[node].sum;
+            return;
+        }
+        if (l <= lo && hi <= r) {
+            minPrefix = min(minPrefix, prefix + _nodes[node].minPrefix);
+            prefix += _nodes[node].sum;
+            return;
+        }
+
+        const size_t mid = lo + (hi - lo) / 2;
+        _minPrefix(_nodes[node].left, lo, mid, l, r, prefix, minPrefix);
+        _minPrefix(_nodes[node].right, mid + 1, hi, l, r, prefix, minPrefix);
+    }
+
+    size_t _numGaps;
+    vector<Node> _nodes;
+    vector<int32_t> _roots;  // one version per row
+};
+
+// The polygon on its compressed coordinates: every distinct x (y) and every gap between two
+// consecutive ones becomes one column (row), plus a padding column (row) on each side, so each
+// cell is either entirely inside or entirely outside the polygon. Rather than rasterizing the
+// whole grid, the polygon is swept once by rows and once by columns (see WindingSweep).
+//
+// A rectangle between two vertices is inside the polygon iff the rows and columns right inside its
+// sides are: any edge entering the rectangle has to cross one of them, and without edges inside,
+// the rectangle is entirely on one side of the boundary. A rectangle of a single row or column is
+// checked along that row or column itself.
+class CompressedPolygon {
+public:
+    CompressedPolygon(const vector<coord_big_t> &vertices) {
+        for (const auto &vertex : vertices) {
+            _xs.push_back(vertex.first);
+            _ys.push_back(vertex.second);
+        }
+        sort(_xs.begin(), _xs.end());
+        _xs.erase(unique(_xs.begin(), _xs.end()), _xs.end());
+        sort(_ys.begin(), _ys.end());
+        _ys.erase(unique(_ys.begin(), _ys.end()), _ys.end());
+
+        const size_t width = 2 * _xs.size() + 1;
+        const size_t height = 2 * _ys.size() + 1;
+
+        for (const auto &vertex : vertices) {
+            _cells.push_back({_column(vertex.first), _row(vertex.second)});
+        }
+
+        vector<WindingSweep::edge_t> verticalEdges;
+        vector<WindingSweep::edge_t> horizontalEdges;
+        for (size_t i = 0; i < _cells.size(); i++) {
+            const auto &from = _cells[i];
+            const auto &to = _cells[(i + 1) % _cells.size()];
+            if (from.first == to.first && from.second != to.second) {
+                verticalEdges.push_back({from.first, from.second, to.second});
+            } else if (from.second == to.second && from.first != to.first) {
+                horizontalEdges.push_back({from.second, from.first, to.first});
+            } else if (from != to) {
+                cout << "Red tiles " << i << " and " << (i + 1) % _cells.size() << " are not on the same row or column!" << endl;
+                exit(1);
+            }
+        }
+
+        _rows = make_unique<WindingSweep>(verticalEdges, height, width);
+        _columns = make_unique<WindingSweep>(horizontalEdges, width, height);
+    }
+
+    // cell of every vertex, in input order
+    const vector<coord_t> &vertexCells() const {
+        return _cells;
+    }
+
+    bool containsRectangle(const coord_t &cellA, const coord_t &cellB) const {
+        const size_t minCol = min(cellA.first, cellB.first);
+        const size_t maxCol = max(cellA.first, cellB.first);
+        const size_t minRow = min(cellA.second, cellB.second);
+        const size_t maxRow = max(cellA.second, cellB.second);
+
+        if (minRow == maxRow || minCol == maxCol) {
+            return (minCol == maxCol || _rows->isCovered(minRow, minCol, maxCol)) &&
+                   (minRow == maxRow || _columns->isCovered(minCol, minRow, maxRow));
+        }
+
+        return _rows->isCovered(minRow + 1, minCol, maxCol) && _rows->isCovered(maxRow - 1, minCol, maxCol) &&
+               _columns->isCovered(minCol + 1, minRow, maxRow) && _columns->isCovered(maxCol - 1, minRow, maxRow);
+    }
+
+private:
+    size_t _column(const uint64_t x) const {
+        return 2 * (lower_bound(_xs.begin(), _xs.end(), x) - _xs.begin()) + 1;
+    }
+
+    size_t _row(const uint64_t y) const {
+        return 2 * (lower_bound(_ys.begin(), _ys.end(), y) - _ys.begin()) + 1;
+    }
+
+    vector<uint64_t> _xs;
+    vector<uint64_t> _ys;
+    vector<coord_t> _cells;
+    unique_ptr<WindingSweep> _rows;
+    unique_ptr<WindingSweep> _columns;
+};
+
 void part2(istream& inputFile) {
     vector<coord_big_t> redSquares;
     while (!inputFile.eof()) {
@@ -54,58 +260,54 @@ void part2(istream& inputFile) {
         redSquares.push_back({stoull(coords[0]), stoull(coords[1])});
     }
 
-    vector<Edge> edges;
-    for (size_t i = 0; i < redSquares.size(); i++) {
-        edges.push_back({redSquares[i], redSquares[(i + 1) % redSquares.size()]});
+    const CompressedPolygon polygon(redSquares);
+    const auto &cells = polygon.vertexCells();
+
+    // The largest rectangle a square can be a corner of is bounded by the farthest corner of the
+    // bounding box. Going through the squares by decreasing bound, the scan stops as soon as no
+    // remaining square can beat the best rectangle found so far.
+    uint64_t minX = UINT64_MAX, minY = UINT64_MAX, maxX = 0, maxY = 0;
+    for (const auto &square : redSquares) {
+        minX = min(minX, square.first);
+        maxX = max(maxX, square.first);
+        minY = min(minY, square.second);
+        maxY = max(maxY, square.second);
     }
 
-    uint64_t largestArea = 0;
+    vector<pair<uint64_t, size_t>> squaresByBound;
     for (size_t i = 0; i < redSquares.size(); i++) {
-        for (size_t j = i + 1; j < redSquares.size(); j++) {
-            const auto minX = min(redSquares[i].first, redSquares[j].first);
-            const auto minY = min(redSquares[i].second, redSquares[j].second);
-            const auto maxX = max(redSquares[i].first, redSquares[j].first);
-            const auto maxY = max(redSquares[i].second, redSquares[j].second);
-
-            const auto area = getRectangleArea(redSquares[i], redSquares[j]);
-            if (area <= largestArea) {
-                continue;
+        const auto &square = redSquares[i];
+        const uint64_t bound = (max(square.first - minX, maxX - square.first) + 1) *
+                               (max(square.second - minY, maxY - square.second) + 1);
+        squaresByBound.push_back({bound, i});
+    }
+    sort(squaresByBound.begin(), squaresByBound.end(), greater<>());
+
+    atomic<uint64_t> largestArea = 0;
+    const size_t numWorkers = getNumWorkers(squaresByBound.size());
+    parallelFor(numWorkers, [&](const size_t worker) {
+        // interleaved so every worker gets its share of the squares with the largest bounds
+        for (size_t k = worker; k < squaresByBound.size(); k += numWorkers) {
+            const auto [bound, i] = squaresByBound[k];
+            if (bound <= largestArea.load(memory_order_relaxed)) {
+                break;
             }
 
-            bool isWithinBoundaries = true;
-            for (const auto &edge : edges) {
-                if (edge.isVertical()) {
-                    const auto edgeX = edge.pointA.first;
-                    if (edgeX > minX && edgeX < maxX) {
-                        const auto edgeYMin = min(edge.pointA.second, edge.pointB.second);
-                        const auto edgeYMax = max(edge.pointA.second, edge.pointB.second);
-
-                        if (max(minY, edgeYMin) < min(maxY, edgeYMax)) {
-                            isWithinBoundaries = false;
-                            break;
-                        }
-                    }
-                } else {
-                    const auto edgeY = edge.pointA.second;
-                    if (edgeY > minY && edgeY < maxY) {
-                        const auto edgeXMin = min(edge.pointA.first, edge.pointB.first);
-                        const auto edgeXMax = max(edge.pointA.first, edge.pointB.first);
-
-                        if (max(minX, edgeXMin) < min(maxX, edgeXMax)) {
-                            isWithinBoundaries = false;
-                            break;
-                        }
-                    }
+            // a pair is bounded by its smaller bound, so it is only checked from its later square
+            for (size_t l = 0; l < k; l++) {
+                const size_t j = squaresByBound[l].second;
+                const uint64_t area = (max(redSquares[i].first, redSquares[j].first) - min(redSquares[i].first, redSquares[j].first) + 1) *
+                                      (max(redSquares[i].second, redSquares[j].second) - min(redSquares[i].second, redSquares[j].second) + 1);
+
+                uint64_t currentLargest = largestArea.load(memory_order_relaxed);
+                if (area <= currentLargest || !polygon.containsRectangle(cells[i], cells[j])) {
+                    continue;
                 }
-            }
 
-            if (!isWithinBoundaries) {
-                continue;
+                while (area > currentLargest && !largestArea.compare_exchange_weak(currentLargest, area)) {}
             }
-
-            largestArea = max(largestArea, area);
         }
-    }
+    });
 
     cout << largestArea << endl;
 }
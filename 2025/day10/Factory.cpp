@@ -1,188 +1,100 @@
 #include "../../util/BasicIncludes.h"
 #include "../../util/MathUtil.h"
 #include "../../util/StringUtil.h"
-#include "../../util/Types.h"
+#include "../../util/LinearSystem.h"
+#include "../../util/Parallel.h"
 
-#include <queue>
-#include <unordered_set>
+#include <bit>
+#include <numeric>
+#include <optional>
+#include <vector>
 
 using namespace std;
-using namespace aoc::util::types;
+using namespace aoc::util::linear;
+using namespace aoc::util::parallel;
 
-using ll = long long;
+struct Machine {
+    string goalLights;
+    vector<vector<size_t>> buttonSchematics;
+    vector<int64_t> joltageRequirements;
+};
 
-const string pressButton(const string &lights, const vector<size_t> &button) {
-    string newLights = lights;
-    for (const auto &b : button) {
-        if (lights[b] == '.') {
-            newLights[b] = '#';
-        } else {
-            newLights[b] = '.';
-        }
-    }
-
-    return newLights;
-}
-
-const size_t getButtonPressesP1(const string &goalLights, const vector<vector<size_t>> &buttonSchematics) {
-    const string initialLights(goalLights.size(), '.');
-
-    // state: {current lights configuration, number of button presses}
-    queue<pair<string, size_t>> states;
-    unordered_set<string> visited;
-
-    states.emplace(initialLights, 0);
-    visited.insert(initialLights);
-
-    while (!states.empty()) {
-        auto [currentLights, buttonPresses] = states.front();
-        states.pop();
-
-        if (currentLights == goalLights) {
-            return buttonPresses;
-        }
+const Machine parseMachine(const string &line) {
+    Machine machine;
 
-        // press each button
-        for (size_t i = 0; i < buttonSchematics.size(); i++) {
-            const string nextLights = pressButton(currentLights, buttonSchematics[i]);
+    const auto manualStr = aoc::util::string::split(line, ' ');
+    machine.goalLights = manualStr[0].substr(1, manualStr[0].size() - 2);
 
-            if (visited.contains(nextLights)) {
-                continue;
-            }
+    for (size_t i = 1; i < manualStr.size() - 1; i++) {
+        const auto buttonSchematicsRaw = manualStr[i];
+        const auto buttonSchematicsStr = buttonSchematicsRaw.substr(1, buttonSchematicsRaw.size() - 2);
+        const auto buttonsValues = aoc::util::string::split(buttonSchematicsStr, ',');
 
-            visited.insert(nextLights);
-            states.emplace(nextLights, buttonPresses + 1);
+        vector<size_t> buttons;
+        for (const auto &b : buttonsValues) {
+            buttons.push_back(stoull(b));
         }
+        machine.buttonSchematics.push_back(buttons);
     }
 
-    return 0;
-}
-
-const string serializeJoltages(const vector<size_t> &joltages) {
-    string serialization;
-    for (const auto &j : joltages) {
-        serialization += to_string(j) + ",";
+    const auto joltagesRaw = manualStr[manualStr.size() - 1];
+    const auto joltagesStr = joltagesRaw.substr(1, joltagesRaw.size() - 2);
+    const auto joltageValues = aoc::util::string::split(joltagesStr, ',');
+    for (const auto &j : joltageValues) {
+        machine.joltageRequirements.push_back(stoll(j));
     }
 
-    return serialization;
+    return machine;
 }
 
-const vector<vector<size_t>> convertButtons(const size_t numJoltages, const vector<vector<size_t>> &buttonSchematics) {
-    vector<vector<size_t>> joltageIncrements;
+const vector<Machine> readMachines(istream& inputFile) {
+    vector<Machine> machines;
+    while (!inputFile.eof()) {
+        string line;
+        getline(inputFile, line);
 
-    for (const auto &button : buttonSchematics) {
-        vector<size_t> increments(numJoltages, 0);
-        for (const auto &b : button) {
-            increments[b] = 1;
+        if (line.empty()) {
+            continue;
         }
-        joltageIncrements.push_back(increments);
+        machines.push_back(parseMachine(line));
     }
 
-    return joltageIncrements;
+    return machines;
 }
 
-// This is TOO SLOW for the search space...
-const size_t getButtonPressesP2BFS(const vector<size_t> &goalJoltages, const vector<vector<size_t>> &buttonSchematics) {
-    // state: {current joltage values, number of button presses}
-    queue<pair<vector<size_t>, size_t>> states;
-    unordered_set<string> visited;
-
-    vector<size_t> startJoltages(goalJoltages.size(), 0);
-    states.emplace(startJoltages, 0);
-    visited.insert(serializeJoltages(startJoltages));
-
-    const auto joltageIncrements = convertButtons(goalJoltages.size(), buttonSchematics);
-
-    while (!states.empty()) {
-        auto [currentJoltages, buttonPresses] = states.front();
-        states.pop();
-
-        if (currentJoltages == goalJoltages) {
-            return buttonPresses;
-        }
-
-        // press each button
-        for (size_t i = 0; i < buttonSchematics.size(); i++) {
-            vector<size_t> nextJoltages = currentJoltages;
-            bool isValid = true;
-
-            for (size_t j = 0; j < nextJoltages.size(); j++) {
-                nextJoltages[j] += joltageIncrements[i][j];
-                if (nextJoltages[i] > goalJoltages[i]) {
-                    isValid = false;
-                    break;
-                }
-            }
-
-            if (isValid) {
-                const auto key = serializeJoltages(nextJoltages);
-                if (visited.contains(key)) {
-                    continue;
-                }
+// Pressing a button twice undoes it, so each button is pressed at most once and the lights are a
+// linear system over GF(2): one bitmask row of buttons per light.
+const optional<uint64_t> getButtonPressesP1(const Machine &machine) {
+    const size_t numLights = machine.goalLights.size();
+    if (machine.buttonSchematics.size() > 64) {
+        cout << "Can not handle more than 64 buttons per machine!" << endl;
+        exit(1);
+    }
 
-                visited.insert(key);
-                states.emplace(nextJoltages, buttonPresses + 1);
+    vector<uint64_t> rows(numLights, 0);
+    for (size_t j = 0; j < machine.buttonSchematics.size(); ++j) {
+        for (const size_t light : machine.buttonSchematics[j]) {
+            if (light < numLights) {
+                rows[light] |= 1ull << j;
             }
         }
     }
 
-    return 0;
-}
-
-// Branch-and-bound solver: find non-negative integer x such that A x = b and sum(x) is minimized
-uint64_t getButtonPressesP2(const vector<vector<ll>>& A, const vector<ll>& b) {
-    int m = A.size();   // number of counters
-    int n = A[0].size(); // number of buttons
-
-    ll best = LLONG_MAX / 2; // a very large number
-
-    // Upper bound for each button (safe but tight enough)
-    vector<ll> upper(n, 0);
-    for (int j = 0; j < n; ++j) {
-        for (int i = 0; i < m; ++i) {
-            if (A[i][j] > 0) upper[j] = max(upper[j], b[i]);
-        }
-        upper[j] += 100; // safety margin
+    vector<uint8_t> rhs(numLights, 0);
+    for (size_t i = 0; i < numLights; ++i) {
+        rhs[i] = machine.goalLights[i] == '#';
     }
 
-    vector<ll> x(n, 0); // current solution
-
-    // Recursive function that tries all possible values for the remaining buttons
-    function<void(int, ll)> search = [&](int button, ll current_presses) {
-        if (current_presses >= best) return; // prune: already worse than best found
-
-        if (button == n) {
-            // Check if this solution satisfies A x == b
-            vector<ll> result(m, 0);
-            for (int j = 0; j < n; ++j) {
-                for (int i = 0; i < m; ++i) {
-                    result[i] += x[j] * A[i][j];
-                }
-            }
-            if (result == b) {
-                best = current_presses;
-            }
-            return;
-        }
-
-        // Try every possible number of presses for this button
-        for (ll presses = 0; presses <= upper[button]; ++presses) {
-            x[button] = presses;
-            search(button + 1, current_presses + presses);
-            // Early stop if adding more presses can't improve the best
-            if (current_presses + presses >= best) break;
-        }
-        x[button] = 0; // reset
-    };
-
-    search(0, 0); // start from button 0 with 0 presses
-
-    return (best == LLONG_MAX / 2) ? 0 : best;
+    const auto presses = solveMinimalWeightGF2(rows, rhs, machine.buttonSchematics.size());
+    if (!presses) {
+        return nullopt;
+    }
+    return popcount(*presses);
 }
 
 // Build matrix A (rows = counters, columns = buttons)
-vector<vector<ll>> buildMatrixA(size_t numCounters, const vector<vector<size_t>>& buttonSchematic) {
-    vector<vector<ll>> A(numCounters, vector<ll>(buttonSchematic.size(), 0));
+int_matrix_t buildMatrixA(size_t numCounters, const vector<vector<size_t>>& buttonSchematic) {
+    int_matrix_t A(numCounters, vector<int64_t>(buttonSchematic.size(), 0));
     for (size_t j = 0; j < buttonSchematic.size(); ++j) {
         for (size_t c : buttonSchematic[j]) {
             if (c < numCounters) A[c][j] = 1;
@@ -191,87 +103,43 @@ vector<vector<ll>> buildMatrixA(size_t numCounters, const vector<vector<size_t>>
     return A;
 }
 
-void part1(istream& inputFile) {
-    uint64_t totalButtonPresses = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
-
-        string goalLights = "";
-        vector<vector<size_t>> buttonSchematics;
-        vector<size_t> joltageRequirements;
-
-        const auto manualStr = aoc::util::string::split(line, ' ');
-        goalLights = manualStr[0].substr(1, manualStr[0].size() - 2);
-
-        for (size_t i = 1; i < manualStr.size() - 1; i++) {
-            const auto buttonSchematicsRaw = manualStr[i];
-            const auto buttonSchematicsStr = buttonSchematicsRaw.substr(1, buttonSchematicsRaw.size() - 2);
-            const auto buttonsValues = aoc::util::string::split(buttonSchematicsStr, ',');
-
-            vector<size_t> buttons;
-            for (const auto &b : buttonsValues) {
-                buttons.push_back(stoull(b));
-            }
-            buttonSchematics.push_back(buttons);
-        }
-
-        const auto joltagesRaw = manualStr[manualStr.size() - 1];
-        const auto joltagesStr = joltagesRaw.substr(1, joltagesRaw.size() - 2);
-        const auto joltageValues = aoc::util::string::split(joltagesStr, ',');
-        for (const auto &j : joltageValues) {
-            joltageRequirements.push_back(stoull(j));
-        }
-
-        const auto numButtonPresses = getButtonPressesP1(goalLights, buttonSchematics);
-        totalButtonPresses += numButtonPresses;
+// Non-negative integer x such that A x = b and sum(x) is minimized
+const optional<uint64_t> getButtonPressesP2(const Machine &machine) {
+    const auto A = buildMatrixA(machine.joltageRequirements.size(), machine.buttonSchematics);
+    const auto presses = solveMinimalNonNegative(A, machine.joltageRequirements);
+    if (!presses) {
+        return nullopt;
     }
-
-    cout << totalButtonPresses << endl;
+    return accumulate(presses->begin(), presses->end(), 0ull);
 }
 
-void part2(istream& inputFile) {
-    uint64_t totalButtonPresses = 0;
-    size_t i = 0;
-    while (!inputFile.eof()) {
-        string line;
-        getline(inputFile, line);
+template <typename F>
+uint64_t sumButtonPresses(const vector<Machine> &machines, F &&getButtonPresses) {
+    vector<optional<uint64_t>> buttonPresses(machines.size());
+    parallelFor(machines.size(), [&](const size_t i) {
+        buttonPresses[i] = getButtonPresses(machines[i]);
+    });
 
-        string goalLights = "";
-        vector<vector<size_t>> buttonSchematics;
-        vector<ll> joltageRequirements;
-
-        const auto manualStr = aoc::util::string::split(line, ' ');
-        goalLights = manualStr[0].substr(1, manualStr[0].size() - 2);
-
-        for (size_t i = 1; i < manualStr.size() - 1; i++) {
-            const auto buttonSchematicsRaw = manualStr[i];
-            const auto buttonSchematicsStr = buttonSchematicsRaw.substr(1, buttonSchematicsRaw.size() - 2);
-            const auto buttonsValues = aoc::util::string::split(buttonSchematicsStr, ',');
-
-            vector<size_t> buttons;
-            for (const auto &b : buttonsValues) {
-                buttons.push_back(stoull(b));
-            }
-            buttonSchematics.push_back(buttons);
-        }
-
-        const auto joltagesRaw = manualStr[manualStr.size() - 1];
-        const auto joltagesStr = joltagesRaw.substr(1, joltagesRaw.size() - 2);
-        const auto joltageValues = aoc::util::string::split(joltagesStr, ',');
-        for (const auto &j : joltageValues) {
-            joltageRequirements.push_back(stoull(j));
+    uint64_t totalButtonPresses = 0;
+    for (size_t i = 0; i < machines.size(); i++) {
+        if (!buttonPresses[i]) {
+            cout << "Machine " << i << " can not be configured!" << endl;
+            exit(1);
         }
+        totalButtonPresses += *buttonPresses[i];
+    }
 
-        cout << "i= " << i << endl;
-
-        const auto numButtonPresses = getButtonPressesP2(buildMatrixA(joltageRequirements.size(), buttonSchematics), joltageRequirements);
-        totalButtonPresses += numButtonPresses;
+    return totalButtonPresses;
+}
 
-        i += 1;
-    }
+void part1(istream& inputFile) {
+    const auto machines = readMachines(inputFile);
+    cout << sumButtonPresses(machines, getButtonPressesP1) << endl;
+}
 
-    cout << totalButtonPresses << endl;
+void part2(istream& inputFile) {
+    const auto machines = readMachines(inputFile);
+    cout << sumButtonPresses(machines, getButtonPressesP2) << endl;
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+
+namespace aoc {
+namespace util {
+namespace int128 {
+
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
+
+// iostreams have no overload for the 128-bit integers
+static inline std::string toString(uint128_t n) {
+    if (n == 0) {
+        return "0";
+    }
+
+    std::string s;
+    while (n) {
+        s += static_cast<char>('0' + static_cast<int>(n % 10));
+        n /= 10;
+    }
+    std::reverse(s.begin(), s.end());
+
+    return s;
+}
+
+static inline std::string toString(const int128_t n) {
+    if (n < 0) {
+        // negate in unsigned arithmetic, so the lowest value does not overflow
+        return "-" + toString(-static_cast<uint128_t>(n));
+    }
+
+    return toString(static_cast<uint128_t>(n));
+}
+
+}  // namespace int128
+}  // namespace util
+}  // namespace aoc
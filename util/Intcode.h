@@ -0,0 +1,306 @@
+#pragma once
+
+#include "StringUtil.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aoc {
+namespace util {
+namespace intcode {
+
+typedef int64_t cell_t;
+typedef std::vector<cell_t> program_t;
+
+enum Status {
+    kRunning = 0,
+    kHalted,
+    kNeedsInput,
+    kFault,
+};
+
+static inline program_t parseProgram(const std::string &line) {
+    return aoc::util::string::parseDelimSeparatedNumbers<cell_t>(line, ',');
+}
+
+// Intcode instructions are decoded from their cell value through a table built once for every
+// possible encoding (opcode + 3 parameter mode digits), so self-modifying programs never need to
+// invalidate anything.
+struct DecodedInstruction {
+    uint8_t op = 0;  // index into the dispatch table, 0 = invalid
+    uint8_t numParams = 0;
+    std::array<uint8_t, 3> modes = {0, 0, 0};
+};
+
+enum Opcode : uint8_t {
+    kInvalid = 0,
+    kAdd,
+    kMul,
+    kIn,
+    kOut,
+    kJumpIfTrue,
+    kJumpIfFalse,
+    kLessThan,
+    kEquals,
+    kAdjustBase,
+    kHalt,
+    kOpcodeCount,
+};
+
+constexpr cell_t kMaxEncodedInstruction = 22300;  // 3 modes of at most 2, followed by the 2-digit opcode
+constexpr cell_t kMaxAddress = 1ll << 32;
+
+static inline const std::vector<DecodedInstruction> &getDecodeTable() {
+    static const std::vector<DecodedInstruction> decodeTable = []() {
+        const std::array<uint8_t, 100> numParams = [] {
+            std::array<uint8_t, 100> n = {};
+            n[kAdd] = 3; n[kMul] = 3; n[kIn] = 1; n[kOut] = 1; n[kJumpIfTrue] = 2;
+            n[kJumpIfFalse] = 2; n[kLessThan] = 3; n[kEquals] = 3; n[kAdjustBase] = 1;
+            return n;
+        }();
+
+        std::vector<DecodedInstruction> table(kMaxEncodedInstruction);
+        for (cell_t value = 0; value < kMaxEncodedInstruction; value++) {
+            const auto opcode = value % 100;
+            const bool isValidOpcode = (opcode >= kAdd && opcode <= kAdjustBase) || opcode == 99;
+            if (!isValidOpcode) {
+                continue;
+            }
+
+            DecodedInstruction decoded;
+            decoded.op = opcode == 99 ? static_cast<uint8_t>(kHalt) : static_cast<uint8_t>(opcode);
+            decoded.numParams = opcode == 99 ? 0 : numParams[opcode];
+
+            bool validModes = true;
+            cell_t modes = value / 100;
+            for (size_t i = 0; i < decoded.modes.size(); i++) {
+                decoded.modes[i] = modes % 10;
+                validModes &= decoded.modes[i] <= 2;
+                modes /= 10;
+            }
+
+            if (validModes) {
+                table[value] = decoded;
+            }
+        }
+
+        return table;
+    }();
+
+    return decodeTable;
+}
+
+// Intcode machine with 64-bit cells. Memory is split in fixed-size pages shared between copies of
+// the machine and only cloned on write, so forking a machine (e.g. from a common prefix of
+// execution) costs a copy of the page table instead of the whole memory.
+class IntcodeVM {
+public:
+    static constexpr size_t kPageBits = 10;
+    static constexpr size_t kPageSize = 1 << kPageBits;
+
+    typedef std::array<cell_t, kPageSize> page_t;
+
+    IntcodeVM() = default;
+
+    IntcodeVM(const program_t &program) {
+        _pages.resize((program.size() + kPageSize - 1) / kPageSize);
+        for (size_t pageIdx = 0; pageIdx < _pages.size(); pageIdx++) {
+            auto page = std::make_shared<page_t>();
+            page->fill(0);
+
+            const size_t startAddress = pageIdx * kPageSize;
+            const size_t endAddress = std::min(program.size(), startAddress + kPageSize);
+            std::copy(program.begin() + startAddress, program.begin() + endAddress, page->begin());
+
+            _pages[pageIdx] = std::move(page);
+        }
+    }
+
+    // Cheap copy: the pages are shared until either machine writes to them.
+    IntcodeVM fork() const {
+        return *this;
+    }
+
+    cell_t read(const cell_t address) const {
+        const size_t pageIdx = static_cast<size_t>(address) >> kPageBits;
+        if (address < 0 || pageIdx >= _pages.size() || !_pages[pageIdx]) {
+            return 0;
+        }
+        return (*_pages[pageIdx])[address & (kPageSize - 1)];
+    }
+
+    void write(const cell_t address, const cell_t value) {
+        (*_getWritablePage(address))[address & (kPageSize - 1)] = value;
+    }
+
+    void pushInput(const cell_t value) {
+        _inputs.push_back(value);
+    }
+
+    std::deque<cell_t> &outputs() {
+        return _outputs;
+    }
+
+    Status status() const {
+        return _status;
+    }
+
+    size_t numExecutedInstructions() const {
+        return _numExecutedInstructions;
+    }
+
+    // Runs until the program halts, faults, or needs an input that was not provided yet.
+    Status run() {
+        if (_status == kHalted || _status == kFault) {
+            return _status;
+        }
+        _status = kRunning;
+
+        const auto &decodeTable = getDecodeTable();
+        DecodedInstruction decoded;
+        cell_t params[3];
+
+#if defined(__GNUC__)
+        // computed goto: every handler jumps straight to the next one
+        static void *const kDispatchTable[kOpcodeCount] = {
+            &&op_invalid, &&op_add, &&op_mul, &&op_in, &&op_out, &&op_jump_if_true,
+            &&op_jump_if_false, &&op_less_than, &&op_equals, &&op_adjust_base, &&op_halt,
+        };
+#define INTCODE_GOTO(op) goto *kDispatchTable[op]
+#else
+#define INTCODE_GOTO(op)                                                                                    \
+        switch (op) {                                                                                       \
+            case kAdd: goto op_add;                                                                         \
+            case kMul: goto op_mul;                                                                         \
+            case kIn: goto op_in;                                                                           \
+            case kOut: goto op_out;                                                                         \
+            case kJumpIfTrue: goto op_jump_if_true;                                                         \
+            case kJumpIfFalse: goto op_jump_if_false;                                                       \
+            case kLessThan: goto op_less_than;                                                              \
+            case kEquals: goto op_equals;                                                                   \
+            case kAdjustBase: goto op_adjust_base;                                                          \
+            case kHalt: goto op_halt;                                                                       \
+            default: goto op_invalid;                                                                       \
+        }
+#endif
+
+// decodes the instruction at _ip, resolves its parameters to addresses, and jumps to its handler
+#define INTCODE_DISPATCH()                                                                                  \
+        {                                                                                                   \
+            const cell_t value = read(_ip);                                                                 \
+            decoded = (value >= 0 && value < kMaxEncodedInstruction) ? decodeTable[value] : DecodedInstruction(); \
+            for (uint8_t i = 0; i < decoded.numParams; i++) {                                               \
+                params[i] = _resolveAddress(_ip + 1 + i, decoded.modes[i]);                                 \
+                if (params[i] < 0 || params[i] >= kMaxAddress) {                                            \
+                    goto op_invalid;                                                                        \
+                }                                                                                           \
+            }                                                                                               \
+            _numExecutedInstructions += 1;                                                                  \
+            INTCODE_GOTO(decoded.op);                                                                       \
+        }
+
+        INTCODE_DISPATCH();
+
+    op_add:
+        write(params[2], read(params[0]) + read(params[1]));
+        _ip += 4;
+        INTCODE_DISPATCH();
+
+    op_mul:
+        write(params[2], read(params[0]) * read(params[1]));
+        _ip += 4;
+        INTCODE_DISPATCH();
+
+    op_in:
+        if (_inputs.empty()) {
+            _numExecutedInstructions -= 1;
+            _status = kNeedsInput;
+            return _status;
+        }
+        write(params[0], _inputs.front());
+        _inputs.pop_front();
+        _ip += 2;
+        INTCODE_DISPATCH();
+
+    op_out:
+        _outputs.push_back(read(params[0]));
+        _ip += 2;
+        INTCODE_DISPATCH();
+
+    op_jump_if_true:
+        _ip = read(params[0]) != 0 ? read(params[1]) : _ip + 3;
+        INTCODE_DISPATCH();
+
+    op_jump_if_false:
+        _ip = read(params[0]) == 0 ? read(params[1]) : _ip + 3;
+        INTCODE_DISPATCH();
+
+    op_less_than:
+        write(params[2], read(params[0]) < read(params[1]) ? 1 : 0);
+        _ip += 4;
+        INTCODE_DISPATCH();
+
+    op_equals:
+        write(params[2], read(params[0]) == read(params[1]) ? 1 : 0);
+        _ip += 4;
+        INTCODE_DISPATCH();
+
+    op_adjust_base:
+        _relativeBase += read(params[0]);
+        _ip += 2;
+        INTCODE_DISPATCH();
+
+    op_halt:
+        _status = kHalted;
+        return _status;
+
+    op_invalid:
+        _status = kFault;
+        return _status;
+
+#undef INTCODE_DISPATCH
+#undef INTCODE_GOTO
+    }
+
+private:
+    cell_t _resolveAddress(const cell_t paramAddress, const uint8_t mode) const {
+        switch (mode) {
+            case 0: return read(paramAddress);
+            case 1: return paramAddress;
+            default: return _relativeBase + read(paramAddress);
+        }
+    }
+
+    page_t *_getWritablePage(const cell_t address) {
+        const size_t pageIdx = static_cast<size_t>(address) >> kPageBits;
+        if (pageIdx >= _pages.size()) {
+            _pages.resize(pageIdx + 1);
+        }
+
+        auto &page = _pages[pageIdx];
+        if (!page) {
+            page = std::make_shared<page_t>();
+            page->fill(0);
+        } else if (page.use_count() > 1) {
+            page = std::make_shared<page_t>(*page);
+        }
+
+        return page.get();
+    }
+
+    std::vector<std::shared_ptr<page_t>> _pages;
+    std::deque<cell_t> _inputs;
+    std::deque<cell_t> _outputs;
+    cell_t _ip = 0;
+    cell_t _relativeBase = 0;
+    Status _status = kRunning;
+    size_t _numExecutedInstructions = 0;
+};
+
+}  // namespace intcode
+}  // namespace util
+}  // namespace aoc
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+namespace util {
+namespace interval {
+
+typedef std::pair<uint64_t, uint64_t> interval_t;  // inclusive on both ends
+
+// Set of uint64_t values stored as sorted, disjoint, non-adjacent closed intervals. The starts and
+// ends are kept in separate arrays so membership is a search over a dense array of starts.
+class IntervalSet {
+public:
+    // below this many intervals, a linear count of the starts (which vectorizes) beats bisecting
+    static constexpr size_t kLinearSearchSize = 32;
+
+    IntervalSet() = default;
+
+    // Bulk build: sorts the intervals and merges the ones that overlap or touch.
+    IntervalSet(std::vector<interval_t> intervals) {
+        std::sort(intervals.begin(), intervals.end());
+
+        for (const auto &interval : intervals) {
+            if (interval.first > interval.second) {
+                continue;
+            }
+
+            // second + 1 would overflow for an interval ending at the max value
+            if (!_ends.empty() && (_ends.back() == UINT64_MAX || interval.first <= _ends.back() + 1)) {
+                _ends.back() = std::max(_ends.back(), interval.second);
+            } else {
+                _starts.push_back(interval.first);
+                _ends.push_back(interval.second);
+            }
+        }
+    }
+
+    size_t numIntervals() const {
+        return _starts.size();
+    }
+
+    interval_t interval(const size_t idx) const {
+        return {_starts[idx], _ends[idx]};
+    }
+
+    // Number of values in the set (wraps if the set covers all 2^64 values).
+    uint64_t size() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < _starts.size(); i++) {
+            total += _ends[i] - _starts[i] + 1;
+        }
+        return total;
+    }
+
+    bool contains(const uint64_t value) const {
+        if (_starts.empty()) {
+            return false;
+        }
+
+        const size_t idx = _findLastStartAtMost(value);
+        return _starts[idx] <= value && value <= _ends[idx];
+    }
+
+    // Counts the contained values: the queries are sorted (a copy of them, taken by value) and
+    // answered by a single merge-like sweep over the intervals.
+    size_t countContained(std::vector<uint64_t> values) const {
+        if (_starts.empty()) {
+            return 0;
+        }
+
+        std::sort(values.begin(), values.end());
+
+        size_t count = 0;
+        size_t idx = 0;
+        for (const auto value : values) {
+            while (idx < _ends.size() && _ends[idx] < value) {
+                idx += 1;
+            }
+            if (idx == _ends.size()) {
+                break;
+            }
+            count += _starts[idx] <= value;
+        }
+
+        return count;
+    }
+
+private:
+    // index of the last interval starting at or before value, or 0 if there is none
+    size_t _findLastStartAtMost(const uint64_t value) const {
+        if (_starts.size() <= kLinearSearchSize) {
+            size_t numStartsAtMost = 0;
+            for (const auto start : _starts) {
+                numStartsAtMost += start <= value;
+            }
+            return numStartsAtMost > 0 ? numStartsAtMost - 1 : 0;
+        }
+
+        // branchless bisection: the comparison only selects the next base, which compiles to a cmov
+        const uint64_t *base = _starts.data();
+        size_t n = _starts.size();
+        while (n > 1) {
+            const size_t half = n / 2;
+            base = base[half] <= value ? base + half : base;
+            n -= half;
+        }
+
+        return base - _starts.data();
+    }
+
+    std::vector<uint64_t> _starts;
+    std::vector<uint64_t> _ends;
+};
+
+}  // namespace interval
+}  // namespace util
+}  // namespace aoc
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Int128.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace aoc {
+namespace util {
+namespace recurrence {
+
+using aoc::util::int128::uint128_t;
+
+// Linear system over a fixed-size count vector: after one step,
+//     next[to] = sum(weight(from -> to) * current[from])
+// The transitions are kept as a dense numStates x numStates matrix, so the system can be advanced
+// either one step at a time or by exponentiation by squaring, in O(numStates^3 * log(numSteps)).
+//
+// With modulus == 0 the arithmetic is exact: every product and sum is checked, and step / advance
+// return nothing as soon as a value (a count, or an entry of a matrix power) reaches 2^128.
+// Populations growing exponentially get there after a few hundred to a few thousand steps, so step
+// counts in the 10^12 range need a modulus (of at most 64 bits): every value is then reduced
+// modulo that number, which never overflows, and the results are exact modulo that number.
+class LinearRecurrence {
+public:
+    typedef std::vector<uint128_t> matrix_t;
+
+    LinearRecurrence(const size_t numStates, const uint64_t modulus = 0)
+        : _numStates(numStates), _modulus(modulus), _transitions(numStates * numStates, 0) {}
+
+    size_t numStates() const {
+        return _numStates;
+    }
+
+    uint64_t modulus() const {
+        return _modulus;
+    }
+
+    // Transitions between the same states add up; a sum reaching 2^128 (without a modulus) makes
+    // every later step / advance fail.
+    void addTransition(const size_t from, const size_t to, const uint128_t weight = 1) {
+        auto &cell = _transitions[to * _numStates + from];
+        cell = _add(cell, _reduce(weight), _isTransitionOverflowed);
+    }
+
+    std::optional<std::vector<uint128_t>> step(const std::vector<uint128_t> &counts) const {
+        bool isOverflowed = _isTransitionOverflowed;
+        auto next = _apply(_transitions, _reduceAll(counts), isOverflowed);
+        if (isOverflowed) {
+            return std::nullopt;
+        }
+        return next;
+    }
+
+    std::optional<std::vector<uint128_t>> advance(const std::vector<uint128_t> &counts, uint64_t numSteps) const {
+        bool isOverflowed = _isTransitionOverflowed;
+        auto current = _reduceAll(counts);
+
+        // stepping costs numStates^2 per step, a matrix product numStates^3
+        if (numSteps <= _numStates) {
+            for (uint64_t i = 0; i < numSteps && !isOverflowed; i++) {
+                current = _apply(_transitions, current, isOverflowed);
+            }
+        } else {
+            matrix_t power = _transitions;
+            while (numSteps && !isOverflowed) {
+                if (numSteps & 1) {
+                    current = _apply(power, current, isOverflowed);
+                }
+
+                numSteps >>= 1;
+                if (numSteps) {
+                    power = _multiply(power, power, isOverflowed);
+                }
+            }
+        }
+
+        if (isOverflowed) {
+            return std::nullopt;
+        }
+        return current;
+    }
+
+private:
+    uint128_t _reduce(const uint128_t value) const {
+        return _modulus ? value % _modulus : value;
+    }
+
+    std::vector<uint128_t> _reduceAll(std::vector<uint128_t> values) const {
+        for (auto &value : values) {
+            value = _reduce(value);
+        }
+        return values;
+    }
+
+    // with a modulus, both values are below 2^64, so neither the sum nor the product can overflow
+    uint128_t _add(const uint128_t a, const uint128_t b, bool &isOverflowed) const {
+        uint128_t sum;
+        isOverflowed |= __builtin_add_overflow(a, b, &sum);
+        return _reduce(sum);
+    }
+
+    uint128_t _mulAdd(const uint128_t acc, const uint128_t a, const uint128_t b, bool &isOverflowed) const {
+        uint128_t product;
+        isOverflowed |= __builtin_mul_overflow(a, b, &product);
+        return _add(acc, _reduce(product), isOverflowed);
+    }
+
+    std::vector<uint128_t> _apply(const matrix_t &m, const std::vector<uint128_t> &counts, bool &isOverflowed) const {
+        std::vector<uint128_t> next(_numStates, 0);
+        for (size_t to = 0; to < _numStates; to++) {
+            const uint128_t *row = m.data() + to * _numStates;
+            uint128_t acc = 0;
+            for (size_t from = 0; from < _numStates; from++) {
+                if (row[from] != 0 && counts[from] != 0) {
+                    acc = _mulAdd(acc, row[from], counts[from], isOverflowed);
+                }
+            }
+            next[to] = acc;
+        }
+
+        return next;
+    }
+
+    matrix_t _multiply(const matrix_t &a, const matrix_t &b, bool &isOverflowed) const {
+        matrix_t result(_numStates * _numStates, 0);
+        for (size_t i = 0; i < _numStates; i++) {
+            uint128_t *resultRow = result.data() + i * _numStates;
+            for (size_t k = 0; k < _numStates; k++) {
+                const uint128_t aik = a[i * _numStates + k];
+                if (aik == 0) {
+                    continue;
+                }
+
+                const uint128_t *bRow = b.data() + k * _numStates;
+                for (size_t j = 0; j < _numStates; j++) {
+                    if (bRow[j] != 0) {
+                        resultRow[j] = _mulAdd(resultRow[j], aik, bRow[j], isOverflowed);
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    size_t _numStates;
+    uint64_t _modulus;
+    matrix_t _transitions;  // _transitions[to * _numStates + from]
+    bool _isTransitionOverflowed = false;
+};
+
+}  // namespace recurrence
+}  // namespace util
+}  // namespace aoc
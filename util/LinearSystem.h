@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace aoc {
+namespace util {
+namespace linear {
+
+typedef std::vector<std::vector<int64_t>> int_matrix_t;
+
+// Reduced row echelon form of an augmented integer system A x = b, kept in integers: every pivot
+// row is scaled so all the pivots equal the same positive value, so for a pivot column
+//     pivot * x[pivotColumns[r]] = rhs[r] - sum(rows[r][f] * x[f] for the free columns f)
+struct IntegerEchelonForm {
+    int_matrix_t rows;
+    std::vector<int64_t> rhs;
+    std::vector<size_t> pivotColumns;  // one per row of rows
+    std::vector<size_t> freeColumns;
+    int64_t pivot = 1;
+    bool isConsistent = true;
+};
+
+// Fraction-free Gauss-Jordan elimination: a row is eliminated by cross-multiplying it with the
+// pivot row, then divided by the gcd of its entries so the values stay small.
+static inline IntegerEchelonForm echelonize(int_matrix_t a, std::vector<int64_t> b) {
+    const size_t numRows = a.size();
+    const size_t numCols = numRows > 0 ? a.front().size() : 0;
+
+    const auto reduceRow = [&](const size_t r) {
+        int64_t g = std::abs(b[r]);
+        for (const auto v : a[r]) {
+            g = std::gcd(g, std::abs(v));
+        }
+        if (g > 1) {
+            for (auto &v : a[r]) {
+                v /= g;
+            }
+            b[r] /= g;
+        }
+    };
+
+    IntegerEchelonForm form;
+    size_t rank = 0;
+    for (size_t col = 0; col < numCols; col++) {
+        size_t pivotRow = rank;
+        while (pivotRow < numRows && a[pivotRow][col] == 0) {
+            pivotRow += 1;
+        }
+        if (pivotRow >= numRows) {
+            form.freeColumns.push_back(col);
+            continue;
+        }
+
+        std::swap(a[rank], a[pivotRow]);
+        std::swap(b[rank], b[pivotRow]);
+        if (a[rank][col] < 0) {
+            for (auto &v : a[rank]) {
+                v = -v;
+            }
+            b[rank] = -b[rank];
+        }
+
+        for (size_t r = 0; r < numRows; r++) {
+            if (r == rank || a[r][col] == 0) {
+                continue;
+            }
+
+            const int64_t factor = a[r][col];
+            const int64_t p = a[rank][col];
+            for (size_t c = 0; c < numCols; c++) {
+                a[r][c] = a[r][c] * p - a[rank][c] * factor;
+            }
+            b[r] = b[r] * p - b[rank] * factor;
+            reduceRow(r);
+        }
+
+        form.pivotColumns.push_back(col);
+        rank += 1;
+    }
+
+    // rows left without a pivot read 0 = b
+    for (size_t r = rank; r < numRows; r++) {
+        form.isConsistent &= b[r] == 0;
+    }
+
+    // bring every pivot to the lcm of the pivots
+    for (size_t r = 0; r < rank; r++) {
+        form.pivot = std::lcm(form.pivot, a[r][form.pivotColumns[r]]);
+    }
+    for (size_t r = 0; r < rank; r++) {
+        const int64_t scale = form.pivot / a[r][form.pivotColumns[r]];
+        for (auto &v : a[r]) {
+            v *= scale;
+        }
+        b[r] *= scale;
+    }
+
+    a.resize(rank);
+    b.resize(rank);
+    form.rows = std::move(a);
+    form.rhs = std::move(b);
+
+    return form;
+}
+
+// Non-negative integer solution of A x = b minimizing sum(x), for A with non-negative entries and
+// b >= 0 (so every variable is bounded by the rows it appears in).
+//
+// After elimination only the free variables are searched: each is enumerated within its bound in
+// a depth-first branch and bound, and the pivot variables follow from them. A branch is cut when
+// a pivot variable can no longer be made non-negative by the free variables still unassigned, or
+// when even the most favorable values of those cannot beat the best sum found so far.
+static inline std::optional<std::vector<int64_t>> solveMinimalNonNegative(const int_matrix_t &a, const std::vector<int64_t> &b) {
+    const size_t numCols = a.empty() ? 0 : a.front().size();
+
+    // a column appearing in no row could take any value, so it is left at 0
+    std::vector<int64_t> upperBounds(numCols, 0);
+    for (size_t col = 0; col < numCols; col++) {
+        std::optional<int64_t> bound;
+        for (size_t r = 0; r < a.size(); r++) {
+            if (a[r][col] > 0) {
+                bound = std::min(bound.value_or(b[r] / a[r][col]), b[r] / a[r][col]);
+            }
+        }
+        upperBounds[col] = bound.value_or(0);
+    }
+
+    const auto form = echelonize(a, b);
+    if (!form.isConsistent) {
+        return std::nullopt;
+    }
+
+    const size_t rank = form.rows.size();
+    const int64_t pivot = form.pivot;
+
+    // free variables with the smallest ranges first, so the deeper levels are the cheap ones
+    auto freeColumns = form.freeColumns;
+    std::sort(freeColumns.begin(), freeColumns.end(), [&](const size_t c1, const size_t c2) {
+        return upperBounds[c1] < upperBounds[c2];
+    });
+    const size_t numFree = freeColumns.size();
+
+    // pivot * sum(x) = sum(rhs) + sum(costs[f] * x[f]) over the free variables
+    std::vector<int64_t> costs(numFree, 0);
+    int64_t baseCost = 0;
+    for (size_t r = 0; r < rank; r++) {
+        baseCost += form.rhs[r];
+    }
+    for (size_t f = 0; f < numFree; f++) {
+        costs[f] = pivot;
+        for (size_t r = 0; r < rank; r++) {
+            costs[f] -= form.rows[r][freeColumns[f]];
+        }
+    }
+
+    // suffixMax[f] is the highest contribution of the free variables f.. to each row's remaining
+    // right hand side, and suffixMinCost[f] their lowest contribution to the cost
+    std::vector<std::vector<int64_t>> suffixMax(numFree + 1, std::vector<int64_t>(rank, 0));
+    std::vector<int64_t> suffixMinCost(numFree + 1, 0);
+    for (size_t f = numFree; f-- > 0;) {
+        const int64_t ub = upperBounds[freeColumns[f]];
+        for (size_t r = 0; r < rank; r++) {
+            const int64_t coefficient = -form.rows[r][freeColumns[f]];
+            suffixMax[f][r] = suffixMax[f + 1][r] + std::max<int64_t>(0, coefficient * ub);
+        }
+        suffixMinCost[f] = suffixMinCost[f + 1] + std::min<int64_t>(0, costs[f] * ub);
+    }
+
+    std::optional<int64_t> bestCost;
+    std::vector<int64_t> bestFreeValues;
+    std::vector<int64_t> freeValues(numFree, 0);
+    std::vector<int64_t> remaining = form.rhs;  // rhs minus the assigned free variables
+
+    const auto search = [&](auto &&self, const size_t f, const int64_t cost) -> void {
+        if (bestCost && cost + suffixMinCost[f] >= *bestCost) {
+            return;
+        }
+        for (size_t r = 0; r < rank; r++) {
+            if (remaining[r] + suffixMax[f][r] < 0) {
+                return;
+            }
+        }
+
+        if (f == numFree) {
+            for (size_t r = 0; r < rank; r++) {
+                if (remaining[r] % pivot != 0) {
+                    return;
+                }
+            }
+            bestCost = cost;
+            bestFreeValues = freeValues;
+            return;
+        }
+
+        const size_t col = freeColumns[f];
+        for (int64_t value = 0; value <= upperBounds[col]; value++) {
+            const int64_t nextCost = cost + costs[f] * value;
+            if (costs[f] >= 0 && bestCost && nextCost + suffixMinCost[f + 1] >= *bestCost) {
+                break;  // larger values only cost more
+            }
+
+            bool canRecover = true;
+            for (size_t r = 0; r < rank; r++) {
+                remaining[r] -= form.rows[r][col] * value;
+                canRecover &= form.rows[r][col] <= 0 || remaining[r] + suffixMax[f + 1][r] >= 0;
+            }
+
+            if (canRecover) {
+                freeValues[f] = value;
+                self(self, f + 1, nextCost);
+            }
+
+            for (size_t r = 0; r < rank; r++) {
+                remaining[r] += form.rows[r][col] * value;
+            }
+
+            if (!canRecover) {
+                break;  // a row this variable takes from is already out of reach
+            }
+        }
+        freeValues[f] = 0;
+    };
+    search(search, 0, baseCost);
+
+    if (!bestCost) {
+        return std::nullopt;
+    }
+
+    std::vector<int64_t> x(numCols, 0);
+    for (size_t f = 0; f < numFree; f++) {
+        x[freeColumns[f]] = bestFreeValues[f];
+    }
+    for (size_t r = 0; r < rank; r++) {
+        int64_t value = form.rhs[r];
+        for (size_t f = 0; f < numFree; f++) {
+            value -= form.rows[r][freeColumns[f]] * bestFreeValues[f];
+        }
+        x[form.pivotColumns[r]] = value / pivot;
+    }
+
+    return x;
+}
+
+// Solution of A x = b over GF(2) with the fewest ones. Every row of A is a bitmask over the (at
+// most 64) columns; the free columns are enumerated exhaustively, the pivots follow from them.
+static inline std::optional<uint64_t> solveMinimalWeightGF2(std::vector<uint64_t> rows, std::vector<uint8_t> rhs, const size_t numCols) {
+    std::vector<size_t> pivotColumns;
+    uint64_t freeMask = 0;
+
+    size_t rank = 0;
+    for (size_t col = 0; col < numCols; col++) {
+        const uint64_t bit = 1ull << col;
+
+        size_t pivotRow = rank;
+        while (pivotRow < rows.size() && !(rows[pivotRow] & bit)) {
+            pivotRow += 1;
+        }
+        if (pivotRow == rows.size()) {
+            freeMask |= bit;
+            continue;
+        }
+
+        std::swap(rows[rank], rows[pivotRow]);
+        std::swap(rhs[rank], rhs[pivotRow]);
+        for (size_t r = 0; r < rows.size(); r++) {
+            if (r != rank && (rows[r] & bit)) {
+                rows[r] ^= rows[rank];
+                rhs[r] ^= rhs[rank];
+            }
+        }
+
+        pivotColumns.push_back(col);
+        rank += 1;
+    }
+
+    for (size_t r = rank; r < rows.size(); r++) {
+        if (rhs[r]) {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<uint64_t> best;
+    const int numFree = std::popcount(freeMask);
+    for (uint64_t combination = 0; combination < (1ull << numFree); combination++) {
+        // scatter the combination bits onto the free columns
+        uint64_t x = 0;
+        uint64_t remainingFree = freeMask;
+        for (uint64_t bits = combination; remainingFree; bits >>= 1, remainingFree &= remainingFree - 1) {
+            if (bits & 1) {
+                x |= remainingFree & -remainingFree;
+            }
+        }
+
+        for (size_t r = 0; r < rank; r++) {
+            const bool value = rhs[r] ^ (std::popcount(rows[r] & freeMask & x) & 1);
+            x |= static_cast<uint64_t>(value) << pivotColumns[r];
+        }
+
+        if (!best || std::popcount(x) < std::popcount(*best)) {
+            best = x;
+        }
+    }
+
+    return best;
+}
+
+}  // namespace linear
+}  // namespace util
+}  // namespace aoc
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace aoc {
+namespace util {
+namespace parallel {
+
+static inline size_t getNumWorkers(const size_t numItems) {
+    const size_t hardwareThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(hardwareThreads, numItems));
+}
+
+// Splits [0, numItems) into contiguous chunks, one per worker thread (see getNumWorkers), and
+// calls fn(workerIdx, startIdx, endIdx) once for each chunk. Useful when a worker needs its own
+// scratch state or partial result for the whole chunk; fn must only write to state owned by
+// workerIdx or by the indices of its chunk.
+template <typename F>
+void parallelForChunks(const size_t numItems, F &&fn) {
+    const size_t numWorkers = getNumWorkers(numItems);
+    if (numWorkers == 1) {
+        fn(size_t(0), size_t(0), numItems);
+        return;
+    }
+
+    const size_t chunkSize = (numItems + numWorkers - 1) / numWorkers;
+
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    for (size_t w = 0; w < numWorkers; w++) {
+        const size_t startIdx = w * chunkSize;
+        const size_t endIdx = std::min(numItems, startIdx + chunkSize);
+        if (startIdx >= endIdx) {
+            break;
+        }
+
+        workers.emplace_back([&fn, w, startIdx, endIdx]() {
+            fn(w, startIdx, endIdx);
+        });
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+// Calls fn(i) for every i in [0, numItems), split in contiguous chunks as in parallelForChunks.
+// fn must only write to state owned by index i (e.g. results[i]).
+template <typename F>
+void parallelFor(const size_t numItems, F &&fn) {
+    parallelForChunks(numItems, [&fn](const size_t, const size_t startIdx, const size_t endIdx) {
+        for (size_t i = startIdx; i < endIdx; i++) {
+            fn(i);
+        }
+    });
+}
+
+}  // namespace parallel
+}  // namespace util
+}  // namespace aoc
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Int128.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace aoc {
+namespace util {
+namespace polygon {
+
+using aoc::util::int128::int128_t;
+using aoc::util::int128::uint128_t;
+
+// Simple polygon with its vertices on the integer lattice, built from a stream of vertices in
+// boundary order (clockwise or not); the polygon closes itself from the last vertex back to the
+// first. Only running sums are kept, so the vertices are never stored:
+//   - the doubled signed area, by the shoelace formula: sum(x[i] * y[i+1] - x[i+1] * y[i])
+//   - the lattice points on the boundary: gcd(|dx|, |dy|) for every edge
+// and Pick's theorem, A = interior + boundary / 2 - 1, gives the lattice points inside.
+//
+// The sums are 128-bit, so coordinates up to the full int64_t range stay exact.
+// https://en.wikipedia.org/wiki/Shoelace_formula
+// https://en.wikipedia.org/wiki/Pick%27s_theorem
+class LatticePolygon {
+public:
+    void addVertex(const int64_t x, const int64_t y) {
+        if (_numVertices == 0) {
+            _firstX = x;
+            _firstY = y;
+        } else {
+            _addEdge(_lastX, _lastY, x, y, _doubledArea, _boundaryPoints);
+        }
+
+        _lastX = x;
+        _lastY = y;
+        _numVertices += 1;
+    }
+
+    size_t numVertices() const {
+        return _numVertices;
+    }
+
+    uint128_t doubledArea() const {
+        int128_t doubledArea = _doubledArea;
+        uint128_t boundaryPoints = _boundaryPoints;
+        _close(doubledArea, boundaryPoints);
+
+        return doubledArea < 0 ? -doubledArea : doubledArea;
+    }
+
+    // Lattice points on the edges, which is also the length of an axis-aligned boundary.
+    uint128_t boundaryPoints() const {
+        int128_t doubledArea = _doubledArea;
+        uint128_t boundaryPoints = _boundaryPoints;
+        _close(doubledArea, boundaryPoints);
+
+        return boundaryPoints;
+    }
+
+    // Lattice points strictly inside: 2 * interior = 2 * A - boundary + 2
+    uint128_t interiorPoints() const {
+        if (_numVertices < 3) {
+            return 0;
+        }
+
+        return (doubledArea() - boundaryPoints() + 2) / 2;
+    }
+
+    // Lattice points inside or on the boundary, e.g. the 1x1 cells dug around a trench.
+    uint128_t coveredPoints() const {
+        return interiorPoints() + boundaryPoints();
+    }
+
+private:
+    static void _addEdge(const int64_t x1, const int64_t y1, const int64_t x2, const int64_t y2, int128_t &doubledArea, uint128_t &boundaryPoints) {
+        doubledArea += static_cast<int128_t>(x1) * y2 - static_cast<int128_t>(x2) * y1;
+
+        const int128_t dx = static_cast<int128_t>(x2) - x1;
+        const int128_t dy = static_cast<int128_t>(y2) - y1;
+        const uint128_t absDx = dx < 0 ? -dx : dx;
+        const uint128_t absDy = dy < 0 ? -dy : dy;
+
+        // axis-aligned edges, by far the common case, skip the gcd
+        if (absDx == 0 || absDy == 0) {
+            boundaryPoints += absDx + absDy;
+        } else {
+            boundaryPoints += _gcd(absDx, absDy);
+        }
+    }
+
+    static uint128_t _gcd(uint128_t a, uint128_t b) {
+        while (b) {
+            a %= b;
+            std::swap(a, b);
+        }
+        return a;
+    }
+
+    void _close(int128_t &doubledArea, uint128_t &boundaryPoints) const {
+        if (_numVertices > 1) {
+            _addEdge(_lastX, _lastY, _firstX, _firstY, doubledArea, boundaryPoints);
+        }
+    }
+
+    size_t _numVertices = 0;
+    int64_t _firstX = 0;
+    int64_t _firstY = 0;
+    int64_t _lastX = 0;
+    int64_t _lastY = 0;
+    int128_t _doubledArea = 0;
+    uint128_t _boundaryPoints = 0;
+};
+
+}  // namespace polygon
+}  // namespace util
+}  // namespace aoc
@@ -5,6 +5,7 @@
 #include <locale>
 #include <vector>
 #include <sstream>
+#include <string_view>
 
 namespace aoc {
 namespace util {
@@ -61,6 +62,26 @@ static inline std::vector<std::string> split(const std::string &s, const char de
     return separatedWords;
 }
 
+// Non-empty lines of a text read in one go (e.g. a whole input file); the views point into text.
+static inline std::vector<std::string_view> splitLines(const std::string_view text) {
+    std::vector<std::string_view> lines;
+
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        auto lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+
+        if (lineEnd > lineStart) {
+            lines.push_back(text.substr(lineStart, lineEnd - lineStart));
+        }
+        lineStart = lineEnd + 1;
+    }
+
+    return lines;
+}
+
 template <typename T>
 static inline std::vector<T> parseDelimSeparatedNumbers(const std::string &s, const char delim) {
     std::vector<T> numbers;